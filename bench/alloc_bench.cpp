@@ -0,0 +1,112 @@
+#include "bench_runner_p.h"
+
+#include "collector.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const string COUNTER = R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def step(n):
+    if n > 0:
+      self.value = self.value + n * 2 - 1
+      return self.step(n - 1)
+    return self.value
+
+c = Counter()
+)"s;
+
+string Repeat(const string& text, int count) {
+    string result;
+    for (int i = 0; i < count; ++i) {
+        result += text;
+    }
+    return result;
+}
+
+// Выполняет программу и выводит число размещений объектов в куче и значений, сохранённых без
+// выделения памяти. До хранения Number и Bool внутри ObjectHolder каждое такое значение
+// размещалось в куче. Для объектов в куче выводится статистика пулов object_pool
+void MeasureAllocations(BenchRunner& br, const string& name, const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    ostream null_output(nullptr);
+    runtime::SimpleContext context(null_output);
+
+    const runtime::AllocationStats before = runtime::ObjectHolder::GetAllocationStats();
+    const runtime::PoolStats pool_before = runtime::object_pool::GetStats();
+    br.Run(
+        [&] {
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+        },
+        name, 1);
+    const runtime::AllocationStats& after = runtime::ObjectHolder::GetAllocationStats();
+
+    const runtime::PoolStats& pool_after = runtime::object_pool::GetStats();
+
+    br.Output() << "    heap objects: " << after.heap_objects - before.heap_objects
+                << ", inline values: " << after.inline_values - before.inline_values << endl;
+    br.Output() << "    pool hits: " << pool_after.hits - pool_before.hits
+                << ", misses: " << pool_after.misses - pool_before.misses
+                << ", peak bytes: " << pool_after.peak_bytes << endl;
+}
+
+const string PAIR = R"(
+class Pair:
+  def link(other):
+    self.peer = other
+    other.peer = self
+)"s;
+
+// Создаёт много пар экземпляров, ссылающихся друг на друга, и выводит работу сборщика циклов
+void MeasureCycles(BenchRunner& br, const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    ostream null_output(nullptr);
+    runtime::SimpleContext context(null_output);
+
+    runtime::CycleCollector& collector = runtime::CycleCollector::Instance();
+    const runtime::CollectorStats before = collector.GetStats();
+    br.Run(
+        [&] {
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+        },
+        "cyclic pairs"s, 1);
+    const runtime::CollectorStats& after = collector.GetStats();
+
+    br.Output() << "    collections: " << after.collections - before.collections
+                << ", freed: " << after.freed - before.freed
+                << ", pause: " << (after.total_pause - before.total_pause).count() / 1000 << " us"
+                << ", still tracked: " << collector.GetTrackedCount() << endl;
+}
+
+}  // namespace
+
+void RunAllocationBenchmarks(BenchRunner& br) {
+    MeasureAllocations(br, "arithmetic expressions"s,
+                       "x = 0\n"s + Repeat("x = x + 1 * 2 - 3 / 1\n"s, 10000));
+    MeasureAllocations(br, "comparisons and logic"s,
+                       "x = 1\n"s + Repeat("y = x < 2 and not x == 3 or x > 5\n"s, 10000));
+    MeasureAllocations(br, "string concatenation"s,
+                       "x = 1000\n"s + Repeat("s = str(x) + 'a'\n"s, 10000));
+    MeasureAllocations(br, "method calls with arithmetic"s,
+                       COUNTER + Repeat("x = c.step(10)\n"s, 1000));
+    MeasureCycles(br, PAIR + Repeat("p = Pair()\np.link(Pair())\n"s, 50000));
+}
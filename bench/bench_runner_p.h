@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Простейший замер времени для сравнительных бенчмарков.
+// Каждая функция выполняется repetitions раз, выводится суммарное и среднее время
+class BenchRunner {
+public:
+    explicit BenchRunner(std::ostream& out)
+        : out_(out) {
+    }
+
+    // Возвращает суммарное время в миллисекундах
+    template <class BenchFunc>
+    double Run(BenchFunc func, const std::string& bench_name, int repetitions) {
+        using Clock = std::chrono::steady_clock;
+
+        const auto start = Clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            func();
+        }
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+        out_ << std::left << std::setw(48) << bench_name << std::right << std::fixed
+             << std::setprecision(2) << std::setw(10) << elapsed.count() << " ms total "
+             << std::setw(12) << elapsed.count() * 1000.0 / repetitions << " us/run" << std::endl;
+        return elapsed.count();
+    }
+
+    std::ostream& Output() {
+        return out_;
+    }
+
+private:
+    std::ostream& out_;
+};
+
+#define RUN_BENCH(br, func, repetitions) br.Run(func, #func, repetitions)
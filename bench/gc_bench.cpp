@@ -0,0 +1,78 @@
+#include "bench_runner_p.h"
+
+#include "gc.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <optional>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const string NODES = R"(
+class Node:
+  def __init__(value):
+    self.value = value
+    self.label = 'node ' + str(value)
+
+  def link(other):
+    self.next = other
+    other.prev = self
+    return self.value + other.value
+
+total = 0
+)"s;
+
+string Repeat(const string& text, int count) {
+    string result;
+    for (int i = 0; i < count; ++i) {
+        result += text;
+    }
+    return result;
+}
+
+// Исполняет программу со счётчиком ссылок и с кучей GcHeap, чтобы сравнить способы
+// управления памятью на одной нагрузке
+void CompareMemoryModes(BenchRunner& br, const string& name, const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    ostream null_output(nullptr);
+    runtime::SimpleContext context(null_output);
+
+    for (const runtime::MemoryMode mode : {runtime::MemoryMode::RefCounting, runtime::MemoryMode::TracingGc}) {
+        const bool use_gc = mode == runtime::MemoryMode::TracingGc;
+        optional<runtime::GcHeap> heap;
+        br.Run(
+            [&] {
+                heap.emplace();
+                optional<runtime::GcHeap::Scope> scope;
+                if (use_gc) {
+                    scope.emplace(*heap);
+                }
+                runtime::Closure closure;
+                tree->Execute(closure, context);
+            },
+            name + (use_gc ? " (tracing gc)"s : " (refcount)"s), 10);
+        if (use_gc) {
+            const runtime::GcStats& stats = heap->GetStats();
+            br.Output() << "    last run: collections: " << stats.collections << ", freed: " << stats.freed
+                        << ", pause: " << stats.total_pause.count() / 1000 << " us" << endl;
+        }
+    }
+}
+
+}  // namespace
+
+void RunMemoryModeBenchmarks(BenchRunner& br) {
+    CompareMemoryModes(br, "linked nodes"s,
+                       NODES + Repeat("a = Node(1)\nb = Node(2)\ntotal = total + a.link(b)\n"s, 5000));
+    CompareMemoryModes(br, "string building"s,
+                       "s = ''\n"s + Repeat("s = 'x' + str(7) + s\n"s, 2000));
+}
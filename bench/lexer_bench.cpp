@@ -0,0 +1,197 @@
+#include "bench_runner_p.h"
+
+#include "lexer.h"
+#include "mapped_file.h"
+#include "scan.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string FRAGMENT = R"(
+class Vector2:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  # Длина вектора без извлечения корня
+  def length2():
+    return self.x * self.x + self.y * self.y
+
+  def __str__():
+    return "Vector2(" + str(self.x) + ", " + str(self.y) + ')'
+
+v = Vector2(3, 4)
+if v.length2() >= 25 and not v.x == v.y:
+  print 'long vector', v, v.length2()
+else:
+  print "short vector\t", v
+)"s;
+
+// Программа размером не меньше size байт
+string MakeProgram(size_t size) {
+    string result;
+    result.reserve(size + FRAGMENT.size());
+    while (result.size() < size) {
+        result += FRAGMENT;
+    }
+    return result;
+}
+
+size_t CountTokens(parse::Lexer& lexer) {
+    size_t tokens = 0;
+    while (!lexer.NextToken().Is<parse::token_type::Eof>()) {
+        ++tokens;
+    }
+    return tokens;
+}
+
+constexpr int REPETITIONS = 3;
+
+void PrintThroughput(BenchRunner& br, double ms, size_t bytes, size_t tokens) {
+    const double megabytes = static_cast<double>(bytes) * REPETITIONS / (1024.0 * 1024.0);
+    br.Output() << "    " << tokens << " tokens, " << megabytes * 1000.0 / ms << " MB/s" << endl;
+}
+
+// Сравнивает пропускную способность лексера при чтении из потока, из буфера в памяти
+// и из отображённого в память файла
+void MeasureThroughput(BenchRunner& br, const string& program) {
+    size_t tokens = 0;
+    istringstream input(program);
+    for (const auto mode : {parse::LexerMode::Eager, parse::LexerMode::Streaming}) {
+        const double ms = br.Run(
+            [&] {
+                input.clear();
+                input.seekg(0);
+                parse::Lexer lexer(input, mode);
+                tokens = CountTokens(lexer);
+            },
+            mode == parse::LexerMode::Eager ? "lex 16 MB from istream (eager)"s
+                                            : "lex 16 MB from istream (streaming)"s,
+            REPETITIONS);
+        PrintThroughput(br, ms, program.size(), tokens);
+    }
+
+    double ms = br.Run(
+        [&] {
+            parse::Lexer lexer(string_view{program}, parse::LexerMode::Streaming);
+            tokens = CountTokens(lexer);
+        },
+        "lex 16 MB from string_view (streaming)"s, REPETITIONS);
+    PrintThroughput(br, ms, program.size(), tokens);
+
+    const string path = (filesystem::temp_directory_path() / "mython_lexer_bench.my").string();
+    ofstream(path, ios::binary) << program;
+    {
+        const parse::MappedFile file(path);
+        ms = br.Run(
+            [&] {
+                parse::Lexer lexer(file.GetContents(), parse::LexerMode::Streaming);
+                tokens = CountTokens(lexer);
+            },
+            "lex 16 MB mapped file (streaming)"s, REPETITIONS);
+        PrintThroughput(br, ms, program.size(), tokens);
+    }
+    filesystem::remove(path);
+}
+
+// Текст из длинных комментариев и строковых констант, как в сгенерированных программах
+string MakeCommentsAndStrings(size_t size) {
+    const string line = "# "s + string(100, 'c') + "\ns = '"s + string(100, 's') + "'\n"s
+                      + "    identifier_"s + string(40, 'i') + '\n';
+    string result;
+    result.reserve(size + line.size());
+    while (result.size() < size) {
+        result += line;
+    }
+    return result;
+}
+
+// Сравнивает поиск границ комментариев, строк, идентификаторов и отступов
+// по одному символу и векторными командами
+void MeasureScanners(BenchRunner& br, const string& text) {
+    for (const auto level : {parse::scan::Level::Scalar, parse::scan::Level::Sse2,
+                             parse::scan::Level::Avx2}) {
+        const parse::scan::Scanner* scanner = parse::scan::GetScanner(level);
+        if (scanner == nullptr) {
+            continue;
+        }
+        size_t tokens = 0;
+        const double ms = br.Run(
+            [&] {
+                tokens = 0;
+                const char* p = text.data();
+                const char* const end = p + text.size();
+                // Текст заканчивается переводом строки, поэтому лексема не обрывается на end
+                while (p != end) {
+                    p = scanner->skip_spaces(p, end);
+                    if (*p == '#') {
+                        p = scanner->find_line_end(p, end);
+                    } else if (*p == '\'') {
+                        p = scanner->find_quote_or_escape(p + 1, end, '\'') + 1;
+                    } else if (*p == '\n') {
+                        ++p;
+                    } else {
+                        // Символ '=' не входит в идентификатор и пропускается отдельно
+                        const char* const next = scanner->skip_identifier(p, end);
+                        p = next != p ? next : p + 1;
+                    }
+                    ++tokens;
+                }
+            },
+            level == parse::scan::Level::Scalar ? "scan 16 MB comments/strings (scalar)"s
+            : level == parse::scan::Level::Sse2 ? "scan 16 MB comments/strings (sse2)"s
+                                                : "scan 16 MB comments/strings (avx2)"s,
+            REPETITIONS);
+        PrintThroughput(br, ms, text.size(), tokens);
+    }
+}
+
+// Строка из count слов words, повторяющихся по кругу
+string RepeatWords(const vector<string>& words, size_t count) {
+    string result;
+    for (size_t i = 0; i < count; ++i) {
+        result += words[i % words.size()];
+        result += (i % 16 == 15) ? '\n' : ' ';
+    }
+    return result;
+}
+
+// Идентификаторы, не совпадающие с ключевыми словами, и сами ключевые слова разбираются
+// за одинаковое время: каждое слово сравнивается не более чем с одним ключевым словом
+void MeasureKeywordRecognition(BenchRunner& br) {
+    constexpr size_t WORDS = 1'000'000;
+    const vector<string> identifiers = {
+        "classy"s, "returns"s, "iff"s, "elsewhere"s, "define"s, "whiles"s,  "breaks"s, "cont"s,
+        "printer"s, "android"s, "order"s, "note"s,   "Nones"s,  "Truth"s,  "Falsely"s};
+    const vector<string> keywords = {
+        "class"s, "return"s, "if"s, "else"s, "def"s,  "while"s, "break"s, "continue"s,
+        "print"s, "and"s,    "or"s, "not"s,  "None"s, "True"s,  "False"s};
+    for (const auto* words : {&identifiers, &keywords}) {
+        const string text = RepeatWords(*words, WORDS);
+        size_t tokens = 0;
+        const double ms = br.Run(
+            [&] {
+                parse::Lexer lexer(string_view{text}, parse::LexerMode::Streaming);
+                tokens = CountTokens(lexer);
+            },
+            words == &identifiers ? "lex 1M identifiers"s : "lex 1M keywords"s, REPETITIONS);
+        br.Output() << "    " << ms * 1'000'000.0 / (static_cast<double>(WORDS) * REPETITIONS)
+                    << " ns/word, " << tokens << " tokens" << endl;
+    }
+}
+
+}  // namespace
+
+void RunLexerBenchmarks(BenchRunner& br) {
+    MeasureThroughput(br, MakeProgram(16 * 1024 * 1024));
+    MeasureScanners(br, MakeCommentsAndStrings(16 * 1024 * 1024));
+    MeasureKeywordRecognition(br);
+}
@@ -0,0 +1,30 @@
+/*
+ * Бенчмарки интерпретатора Mython.
+ * Собираются отдельно от интерпретатора вместе со всеми его исходниками, кроме mython/main.cpp:
+ *   g++ -std=c++17 -O2 -I../mython \
+ *       $(find ../mython -name '*.cpp' ! -name main.cpp ! -name '*_test.cpp') *.cpp -lpthread
+ * Запускать с оптимизацией, вывод - время выполнения каждого бенчмарка
+ */
+#include "bench_runner_p.h"
+
+#include <iostream>
+
+void RunVmBenchmarks(BenchRunner& br);
+void RunReturnBenchmarks(BenchRunner& br);
+void RunMethodLookupBenchmarks(BenchRunner& br);
+void RunAllocationBenchmarks(BenchRunner& br);
+void RunParseBenchmarks(BenchRunner& br);
+void RunMemoryModeBenchmarks(BenchRunner& br);
+void RunLexerBenchmarks(BenchRunner& br);
+
+int main() {
+    BenchRunner br(std::cout);
+    RunVmBenchmarks(br);
+    RunReturnBenchmarks(br);
+    RunMethodLookupBenchmarks(br);
+    RunAllocationBenchmarks(br);
+    RunParseBenchmarks(br);
+    RunMemoryModeBenchmarks(br);
+    RunLexerBenchmarks(br);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "bench_runner_p.h"
+
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const int CALL_COUNT = 10000;
+
+// Иерархия из depth классов, метод base определён только в корне, метод own - в каждом классе
+string MakeHierarchyProgram(int depth, const string& call) {
+    string program = R"(
+class C0:
+  def base():
+    return 0
+
+  def own():
+    return 0
+)"s;
+    for (int i = 1; i < depth; ++i) {
+        const string name = "C"s + to_string(i);
+        program += "\nclass "s + name + "(C"s + to_string(i - 1) + "):\n"s;
+        program += "  def own():\n    return "s + to_string(i) + "\n"s;
+    }
+    program += "\nobj = C"s + to_string(depth - 1) + "()\n"s;
+    for (int i = 0; i < CALL_COUNT; ++i) {
+        program += call;
+    }
+    return program;
+}
+
+void BenchHierarchy(BenchRunner& br, const string& name, int depth, const string& call) {
+    istringstream input(MakeHierarchyProgram(depth, call));
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    ostream null_output(nullptr);
+    runtime::SimpleContext context(null_output);
+
+    br.Run(
+        [&] {
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+        },
+        name, 20);
+}
+
+}  // namespace
+
+// Вызов унаследованного метода не должен дорожать с ростом глубины иерархии
+void RunMethodLookupBenchmarks(BenchRunner& br) {
+    BenchHierarchy(br, "10000 calls of own method, depth 1"s, 1, "x = obj.own()\n"s);
+    BenchHierarchy(br, "10000 calls of inherited method, depth 2"s, 2, "x = obj.base()\n"s);
+    BenchHierarchy(br, "10000 calls of inherited method, depth 32"s, 32, "x = obj.base()\n"s);
+    BenchHierarchy(br, "10000 str() of instance, depth 32"s, 32, "x = str(obj)\n"s);
+}
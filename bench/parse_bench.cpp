@@ -0,0 +1,181 @@
+#include "bench_runner_p.h"
+
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const string SHAPES = R"(
+class Rect:
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def area():
+    return self.w * self.h
+
+  def __str__():
+    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
+
+r = Rect(2, 3)
+if r.area() > 5 and not r.w == r.h:
+  print r, r.area()
+else:
+  print 'small'
+)"s;
+
+// Повторяет программу SHAPES count раз, давая классу каждой копии своё имя
+string RepeatShapes(int count) {
+    string result;
+    for (int i = 0; i < count; ++i) {
+        string copy = SHAPES;
+        for (size_t pos = copy.find("Rect"s); pos != string::npos; pos = copy.find("Rect"s, pos + 1)) {
+            copy.insert(pos + 4, to_string(i));
+        }
+        result += copy;
+    }
+    return result;
+}
+
+unique_ptr<runtime::Executable> Parse(const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    return ParseProgram(lexer);
+}
+
+// Разбирает и уничтожает много небольших программ: так работает запуск сценариев,
+// каждый из которых исполняется один раз
+void ParseAndDiscard(BenchRunner& br, const string& program) {
+    br.Run(
+        [&] {
+            auto tree = Parse(program);
+        },
+        "parse and discard small programs"s, 2000);
+}
+
+// Отдельно измеряет разбор и уничтожение одной большой программы
+void ParseThenDestroy(BenchRunner& br, const string& program) {
+    constexpr int REPETITIONS = 20;
+    vector<unique_ptr<runtime::Executable>> trees;
+    trees.reserve(REPETITIONS);
+    br.Run(
+        [&] {
+            trees.push_back(Parse(program));
+        },
+        "parse large program"s, REPETITIONS);
+    br.Run(
+        [&] {
+            trees.pop_back();
+        },
+        "destroy large program"s, REPETITIONS);
+}
+
+// Сравнивает получение всех токенов большой программы в обычном, потоковом и конвейерном режимах
+void LexLargeProgram(BenchRunner& br, const string& program) {
+    const pair<parse::LexerMode, string> modes[] = {
+        {parse::LexerMode::Eager, "lex large program (eager)"s},
+        {parse::LexerMode::Streaming, "lex large program (streaming)"s},
+        {parse::LexerMode::Pipelined, "lex large program (pipelined)"s},
+    };
+    for (const auto& [mode, name] : modes) {
+        size_t max_buffered = 0;
+        br.Run(
+            [&] {
+                istringstream input(program);
+                parse::Lexer lexer(input, mode);
+                while (!lexer.NextToken().Is<parse::token_type::Eof>()) {
+                    max_buffered = max(max_buffered, lexer.GetBufferedTokenCount());
+                }
+            },
+            name, 10);
+        br.Output() << "    max buffered tokens: " << max_buffered << endl;
+    }
+}
+
+// Разбор программы, читаемой из потока: в конвейерном режиме чтение и лексический разбор
+// идут в отдельном потоке одновременно с построением дерева
+void ParseFromStream(BenchRunner& br, const string& program) {
+    for (const auto mode : {parse::LexerMode::Streaming, parse::LexerMode::Pipelined}) {
+        br.Run(
+            [&] {
+                istringstream input(program);
+                parse::Lexer lexer(input, mode);
+                auto tree = ParseProgram(lexer);
+            },
+            mode == parse::LexerMode::Streaming ? "parse large program from stream (streaming)"s
+                                                : "parse large program from stream (pipelined)"s,
+            10);
+    }
+}
+
+// Программа из lines присваиваний длинных плоских выражений по leaves операндов в каждом,
+// как в сгенерированных сценариях
+string MakeFlatExpressions(int lines, int leaves) {
+    const string operators[] = {" + "s, " * "s, " - "s, " / "s};
+    string result = "a = 1\n"s;
+    for (int line = 0; line < lines; ++line) {
+        result += "x = a"s;
+        for (int leaf = 1; leaf < leaves; ++leaf) {
+            result += operators[leaf % 4];
+            result += (leaf % 3 == 0) ? "a"s : to_string(leaf);
+        }
+        result += '\n';
+    }
+    return result;
+}
+
+// Время разбора одного операнда не должно зависеть от числа уровней приоритета операторов
+void ParseFlatExpressions(BenchRunner& br) {
+    constexpr int LINES = 2000;
+    constexpr int LEAVES = 64;
+    constexpr int REPETITIONS = 10;
+    const string program = MakeFlatExpressions(LINES, LEAVES);
+    const double ms = br.Run(
+        [&] {
+            auto tree = Parse(program);
+        },
+        "parse long flat expressions"s, REPETITIONS);
+    br.Output() << "    " << ms * 1'000'000.0 / (static_cast<double>(LINES) * LEAVES * REPETITIONS)
+                << " ns/operand" << endl;
+}
+
+// Сравнивает последовательный и параллельный разбор большой библиотеки классов
+void ParseInParallel(BenchRunner& br, const string& program) {
+    constexpr int REPETITIONS = 5;
+    br.Run(
+        [&] {
+            parse::Lexer lexer(string_view{program});
+            auto tree = ParseProgram(lexer);
+        },
+        "parse class library (sequential)"s, REPETITIONS);
+    const size_t threads = max(thread::hardware_concurrency(), 1U);
+    br.Run(
+        [&] {
+            auto tree = ParseProgramParallel(program, threads);
+        },
+        "parse class library (parallel)"s, REPETITIONS);
+    br.Output() << "    threads: " << threads << endl;
+}
+
+}  // namespace
+
+void RunParseBenchmarks(BenchRunner& br) {
+    ParseAndDiscard(br, SHAPES);
+    ParseThenDestroy(br, RepeatShapes(500));
+    LexLargeProgram(br, RepeatShapes(500));
+    ParseFromStream(br, RepeatShapes(2000));
+    ParseFlatExpressions(br);
+    ParseInParallel(br, RepeatShapes(20000));
+}
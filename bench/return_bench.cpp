@@ -0,0 +1,67 @@
+#include "bench_runner_p.h"
+
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const int CALL_COUNT = 10000;
+
+string MakeCallsProgram(const string& call) {
+    string program = R"(
+class Value:
+  def __init__():
+    self.x = 1
+    self.y = 0
+
+  def get():
+    return self.x
+
+  def touch():
+    self.y = self.x
+
+  def get_nested(n):
+    if n > 0:
+      if n > 1:
+        return self.x
+    return self.y
+
+v = Value()
+)"s;
+    for (int i = 0; i < CALL_COUNT; ++i) {
+        program += call;
+    }
+    return program;
+}
+
+void BenchCalls(BenchRunner& br, const string& name, const string& call) {
+    istringstream input(MakeCallsProgram(call));
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    ostream null_output(nullptr);
+    runtime::SimpleContext context(null_output);
+
+    br.Run(
+        [&] {
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+        },
+        name, 20);
+}
+
+}  // namespace
+
+// N вызовов метода с return и без него: стоимость return должна быть сравнима с обычным вызовом
+void RunReturnBenchmarks(BenchRunner& br) {
+    BenchCalls(br, "10000 calls without return"s, "v.touch()\n"s);
+    BenchCalls(br, "10000 calls with return"s, "x = v.get()\n"s);
+    BenchCalls(br, "10000 calls with return from nested if"s, "x = v.get_nested(2)\n"s);
+}
@@ -0,0 +1,114 @@
+#include "bench_runner_p.h"
+
+#include "bytecode.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+#include "vm.h"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+string Repeat(const string& text, int count) {
+    string result;
+    result.reserve(text.size() * count);
+    for (int i = 0; i < count; ++i) {
+        result += text;
+    }
+    return result;
+}
+
+// Программы из тестов main.cpp, увеличенные повторением тела
+const string ARITHMETICS = Repeat("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2\n"s, 2000);
+
+const string ASSIGNMENTS = Repeat(R"(
+x = 57
+y = 'C++ black belt'
+x = y
+z = x
+x = None
+)"s, 1000);
+
+const string POINTERS = R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add():
+    self.value = self.value + 1
+
+class Dummy:
+  def do_add(counter):
+    counter.add()
+
+x = Counter()
+y = x
+d = Dummy()
+)"s + Repeat("x.add()\ny.add()\nd.do_add(x)\n"s, 1000) + "print x.value\n"s;
+
+const string RECURSION = R"(
+class GCD:
+  def calc(a, b):
+    if a < b:
+      return self.calc(b, a)
+    if b == 0:
+      return a
+    return self.calc(a - b, b)
+
+x = GCD()
+)"s + Repeat("print x.calc(510510, 18629977)\n"s, 100);
+
+// Тот же алгоритм, что и в RECURSION, записанный циклом
+const string LOOP = R"(
+class GCD:
+  def calc(a, b):
+    while b != 0:
+      if a < b:
+        t = a
+        a = b
+        b = t
+        continue
+      a = a - b
+    return a
+
+x = GCD()
+)"s + Repeat("print x.calc(510510, 18629977)\n"s, 100);
+
+void CompareExecutors(BenchRunner& br, const string& name, const string& program, int repetitions) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+    const bytecode::Program code = bytecode::Compile(*tree);
+
+    ostream null_output(nullptr);
+    runtime::SimpleContext context(null_output);
+
+    br.Run(
+        [&] {
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+        },
+        name + " (tree walk)"s, repetitions);
+
+    br.Run(
+        [&] {
+            runtime::Closure closure;
+            runtime::VM(code).Run(closure, context);
+        },
+        name + " (vm)"s, repetitions);
+}
+
+}  // namespace
+
+void RunVmBenchmarks(BenchRunner& br) {
+    CompareExecutors(br, "arithmetics"s, ARITHMETICS, 20);
+    CompareExecutors(br, "assignments"s, ASSIGNMENTS, 20);
+    CompareExecutors(br, "variables are pointers"s, POINTERS, 20);
+    CompareExecutors(br, "recursion"s, RECURSION, 20);
+    CompareExecutors(br, "loop"s, LOOP, 20);
+}
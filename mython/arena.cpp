@@ -0,0 +1,90 @@
+#include "arena.h"
+
+#include <new>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+thread_local Arena* current_arena = nullptr;
+
+// Перед каждым узлом хранится указатель на его арену (nullptr для узлов в куче).
+// Размер заголовка сохраняет выравнивание узла
+constexpr size_t NODE_HEADER_SIZE = alignof(max_align_t);
+static_assert(NODE_HEADER_SIZE >= sizeof(Arena*));
+
+constexpr size_t AlignUp(size_t size) {
+    return (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+}
+
+}  // namespace
+
+void ArenaReleaser::operator()(Arena* arena) const noexcept {
+    arena->Release();
+}
+
+ArenaPtr Arena::Create() {
+    return ArenaPtr(new Arena());
+}
+
+void* Arena::Allocate(size_t size) {
+    size = AlignUp(size);
+    if (static_cast<size_t>(end_ - position_) < size) {
+        const size_t block_size = max(size, BLOCK_SIZE);
+        // operator new[] для std::byte выравнивает блок как минимум по max_align_t
+        position_ = blocks_.emplace_back(new byte[block_size]).get();
+        end_ = position_ + block_size;
+    }
+    void* result = position_;
+    position_ += size;
+    used_bytes_ += size;
+    return result;
+}
+
+Arena* Arena::GetCurrent() {
+    return current_arena;
+}
+
+void* Arena::AllocateNode(size_t size) {
+    Arena* arena = current_arena;
+    void* memory = nullptr;
+    if (arena != nullptr) {
+        memory = arena->Allocate(NODE_HEADER_SIZE + size);
+        arena->AddRef();
+    } else {
+        memory = ::operator new(NODE_HEADER_SIZE + size);
+    }
+    *static_cast<Arena**>(memory) = arena;
+    return static_cast<byte*>(memory) + NODE_HEADER_SIZE;
+}
+
+void Arena::FreeNode(void* node) noexcept {
+    if (node == nullptr) {
+        return;
+    }
+    void* memory = static_cast<byte*>(node) - NODE_HEADER_SIZE;
+    if (Arena* arena = *static_cast<Arena**>(memory)) {
+        arena->Release();
+    } else {
+        ::operator delete(memory);
+    }
+}
+
+void Arena::Release() noexcept {
+    if (--refs_ == 0) {
+        delete this;
+    }
+}
+
+Arena::Scope::Scope(Arena& arena)
+    : previous_(current_arena) {
+    current_arena = &arena;
+}
+
+Arena::Scope::~Scope() {
+    current_arena = previous_;
+}
+
+}  // namespace runtime
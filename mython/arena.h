@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace runtime {
+
+class Arena;
+
+// Освобождает ссылку владельца на арену
+struct ArenaReleaser {
+    void operator()(Arena* arena) const noexcept;
+};
+
+using ArenaPtr = std::unique_ptr<Arena, ArenaReleaser>;
+
+/*
+ * Арена - линейный распределитель памяти для узлов AST.
+ * Узлы размещаются подряд в крупных блоках в порядке создания, освобождение отдельного узла
+ * не возвращает память, а все блоки освобождаются разом вместе с ареной.
+ * Арена уничтожается, когда освобождена ссылка владельца и удалены все размещённые в ней узлы,
+ * поэтому узлы, пережившие владельца (например, тела методов класса), остаются действительными
+ */
+class Arena {
+public:
+    // Размер блока по умолчанию. Узлы большего размера получают отдельный блок
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    // Создаёт пустую арену
+    [[nodiscard]] static ArenaPtr Create();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Выделяет size байт, выровненных по alignof(std::max_align_t)
+    [[nodiscard]] void* Allocate(size_t size);
+
+    // Возвращает число выделенных блоков
+    [[nodiscard]] size_t GetBlockCount() const {
+        return blocks_.size();
+    }
+
+    // Возвращает число байт, выделенных из блоков арены
+    [[nodiscard]] size_t GetUsedBytes() const {
+        return used_bytes_;
+    }
+
+    // Возвращает арену, в которой размещаются узлы в текущем потоке, либо nullptr
+    [[nodiscard]] static Arena* GetCurrent();
+
+    // Размещает узел размера size в текущей арене, а если её нет - в куче
+    [[nodiscard]] static void* AllocateNode(size_t size);
+    // Освобождает узел, размещённый функцией AllocateNode
+    static void FreeNode(void* node) noexcept;
+
+    // Делает арену текущей в пределах своей области видимости
+    class Scope {
+    public:
+        explicit Scope(Arena& arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Arena* previous_;
+    };
+
+private:
+    friend struct ArenaReleaser;
+
+    Arena() = default;
+    ~Arena() = default;
+
+    void AddRef() noexcept {
+        ++refs_;
+    }
+
+    void Release() noexcept;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte* position_ = nullptr;
+    std::byte* end_ = nullptr;
+    size_t used_bytes_ = 0;
+    // Ссылка владельца плюс число неудалённых узлов
+    size_t refs_ = 1;
+};
+
+}  // namespace runtime
@@ -0,0 +1,127 @@
+#include "bytecode.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace runtime {
+
+void Executable::Compile(bytecode::Compiler& compiler) {
+    compiler.Emit(bytecode::OpCode::Execute, compiler.AddNode(*this));
+}
+
+}  // namespace runtime
+
+namespace bytecode {
+
+namespace {
+template <typename T>
+uint32_t IndexOf(vector<T>& items, const T& item) {
+    if (auto it = find(items.begin(), items.end(), item); it != items.end()) {
+        return static_cast<uint32_t>(it - items.begin());
+    }
+    items.push_back(item);
+    return static_cast<uint32_t>(items.size() - 1);
+}
+}  // namespace
+
+Compiler::Compiler(Program& program) : program_(program), chunk_(&program.main) {
+}
+
+void Compiler::Compile(runtime::Executable& node) {
+    node.Compile(*this);
+}
+
+void Compiler::CompileMethods(const runtime::Class& cls) {
+    for (const runtime::Method& method : cls.methods_) {
+        if (program_.methods.count(method.body.get()) != 0) {
+            continue;
+        }
+
+        Chunk* outer_chunk = chunk_;
+        vector<Loop> outer_loops = std::exchange(loops_, {});
+        chunk_ = &program_.methods[method.body.get()];
+        Compile(*method.body);
+        Emit(OpCode::Return);
+        chunk_ = outer_chunk;
+        loops_ = std::move(outer_loops);
+    }
+}
+
+size_t Compiler::Emit(OpCode op, uint32_t a, uint32_t b, uint32_t c) {
+    chunk_->code.push_back({op, a, b, c});
+    return chunk_->code.size() - 1;
+}
+
+size_t Compiler::EmitJump(OpCode op) {
+    return Emit(op);
+}
+
+void Compiler::PatchJump(size_t jump) {
+    chunk_->code[jump].a = static_cast<uint32_t>(chunk_->code.size());
+}
+
+void Compiler::BeginLoop() {
+    loops_.push_back({chunk_->code.size(), {}});
+}
+
+void Compiler::EmitContinue() {
+    Emit(OpCode::Jump, static_cast<uint32_t>(loops_.back().start));
+}
+
+void Compiler::EmitBreak() {
+    loops_.back().breaks.push_back(EmitJump(OpCode::Jump));
+}
+
+void Compiler::EndLoop() {
+    for (const size_t jump : loops_.back().breaks) {
+        PatchJump(jump);
+    }
+    loops_.pop_back();
+}
+
+void Compiler::EmitConstant(runtime::ObjectHolder value) {
+    Emit(OpCode::PushConst, AddConstant(std::move(value)));
+}
+
+uint32_t Compiler::AddName(runtime::Symbol name) {
+    return IndexOf(chunk_->names, name);
+}
+
+uint32_t Compiler::AddClass(const runtime::Class& cls) {
+    return IndexOf(chunk_->classes, &cls);
+}
+
+uint32_t Compiler::AddComparator(const Comparator& cmp) {
+    return IndexOf(chunk_->comparators, &cmp);
+}
+
+uint32_t Compiler::AddNode(runtime::Executable& node) {
+    return IndexOf(chunk_->nodes, &node);
+}
+
+uint32_t Compiler::AddConstant(runtime::ObjectHolder value) {
+    chunk_->constants.push_back(std::move(value));
+    return static_cast<uint32_t>(chunk_->constants.size() - 1);
+}
+
+uint32_t Compiler::AddMethodCache() {
+    chunk_->method_caches.emplace_back();
+    return static_cast<uint32_t>(chunk_->method_caches.size() - 1);
+}
+
+uint32_t Compiler::AddFieldCache() {
+    chunk_->field_caches.emplace_back();
+    return static_cast<uint32_t>(chunk_->field_caches.size() - 1);
+}
+
+Program Compile(runtime::Executable& program) {
+    Program result;
+    Compiler compiler(result);
+    compiler.Compile(program);
+    compiler.Emit(OpCode::Return);
+    return result;
+}
+
+}  // namespace bytecode
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bytecode {
+
+// Коды инструкций стековой виртуальной машины runtime::VM
+enum class OpCode : std::uint8_t {
+    PushConst,         // Помещает на стек constants[a]
+    PushNone,          // Помещает на стек None
+    Pop,               // Снимает значение с вершины стека
+    LoadVar,           // Помещает на стек значение переменной names[a]
+    StoreVar,          // Присваивает переменной names[a] значение с вершины стека, не снимая его
+    LoadSlot,          // Помещает на стек значение слота a текущего кадра
+    StoreSlot,         // Присваивает слоту a значение с вершины стека, не снимая его
+    LoadField,         // Заменяет объект на вершине стека значением его поля names[a], кэш - field_caches[c]
+    StoreField,        // Снимает значение и объект, присваивает полю names[a] через field_caches[c], кладёт значение
+    Print,             // Выводит a значений с вершины стека, оставляя последнее из них
+    CallMethod,        // Вызывает метод names[a] с b аргументами у объекта под ними, кэш - method_caches[c]
+    NewInstance,       // Создаёт экземпляр classes[a] без вызова __init__
+    Construct,         // Создаёт экземпляр classes[a] и вызывает у него __init__ с b аргументами
+    Stringify,         // Заменяет значение на вершине стека его строковым представлением
+    Add,               // Снимает rhs и lhs, кладёт lhs + rhs
+    Sub,               // Снимает rhs и lhs, кладёт lhs - rhs
+    Mult,              // Снимает rhs и lhs, кладёт lhs * rhs
+    Div,               // Снимает rhs и lhs, кладёт lhs / rhs
+    Compare,           // Снимает rhs и lhs, кладёт результат comparators[a](lhs, rhs)
+    Not,               // Заменяет значение на вершине стека его логическим отрицанием
+    ToBool,            // Заменяет значение на вершине стека значением Bool (a - вид операции)
+    JumpIfTrueOrPop,   // Переходит на a, если на вершине стека True, иначе снимает значение
+    JumpIfFalseOrPop,  // Переходит на a, если на вершине стека False, иначе снимает значение
+    JumpIfFalse,       // Снимает значение и переходит на a, если оно приводится к False
+    Jump,              // Переходит на инструкцию a
+    Return,            // Завершает текущий фрагмент, возвращая значение с вершины стека
+    DefineClass,       // Объявляет класс constants[a] в текущей таблице символов
+    Execute,           // Исполняет узел nodes[a] обходом дерева и кладёт результат на стек
+};
+
+// Вид логической операции для инструкции ToBool. Определяет текст ошибки для None
+enum class LogicalOp : std::uint32_t {
+    Or,
+    And,
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+    std::uint32_t c = 0;
+};
+
+using Comparator = std::function<bool(const runtime::ObjectHolder&, const runtime::ObjectHolder&,
+                                      runtime::Context&)>;
+
+// Линейный фрагмент байт-кода вместе с таблицами, на которые ссылаются его инструкции
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<runtime::ObjectHolder> constants;
+    std::vector<runtime::Symbol> names;
+    std::vector<const runtime::Class*> classes;
+    std::vector<const Comparator*> comparators;
+    std::vector<runtime::Executable*> nodes;
+    // Встроенные кэши инструкций CallMethod. Заполняются во время исполнения
+    mutable std::vector<runtime::MethodCache> method_caches;
+    // Встроенные кэши инструкций LoadField и StoreField
+    mutable std::vector<runtime::FieldCache> field_caches;
+};
+
+/*
+ * Скомпилированная программа: основной фрагмент и фрагменты тел методов.
+ * Инструкции ссылаются на узлы и константы AST, поэтому дерево, из которого получена программа,
+ * должно существовать, пока программа используется
+ */
+struct Program {
+    Chunk main;
+    // Фрагменты тел методов, ключ - Method::body
+    std::unordered_map<const runtime::Executable*, Chunk> methods;
+};
+
+// Компилятор AST в байт-код. Узлы дерева генерируют свои инструкции через методы Emit*
+class Compiler {
+public:
+    explicit Compiler(Program& program);
+
+    // Генерирует код узла node в текущий фрагмент
+    void Compile(runtime::Executable& node);
+
+    // Компилирует тела ещё не скомпилированных методов класса cls в отдельные фрагменты
+    void CompileMethods(const runtime::Class& cls);
+
+    // Добавляет инструкцию в конец текущего фрагмента и возвращает её индекс
+    size_t Emit(OpCode op, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0);
+
+    // Добавляет инструкцию перехода с пока неизвестным адресом
+    size_t EmitJump(OpCode op);
+    // Направляет переход jump на позицию, следующую за последней добавленной инструкцией
+    void PatchJump(size_t jump);
+
+    // Начинает цикл, проверка условия которого начинается со следующей инструкции
+    void BeginLoop();
+    // Добавляет переход к проверке условия текущего цикла
+    void EmitContinue();
+    // Добавляет переход за конец текущего цикла
+    void EmitBreak();
+    // Завершает текущий цикл: переходы за его конец ведут на следующую инструкцию
+    void EndLoop();
+
+    void EmitConstant(runtime::ObjectHolder value);
+
+    std::uint32_t AddName(runtime::Symbol name);
+    std::uint32_t AddClass(const runtime::Class& cls);
+    std::uint32_t AddComparator(const Comparator& cmp);
+    std::uint32_t AddNode(runtime::Executable& node);
+    std::uint32_t AddConstant(runtime::ObjectHolder value);
+    // Добавляет в текущий фрагмент пустой кэш для очередного места вызова метода
+    std::uint32_t AddMethodCache();
+    // Добавляет в текущий фрагмент пустой кэш для очередного места доступа к полю
+    std::uint32_t AddFieldCache();
+
+private:
+    // Цикл, код которого генерируется
+    struct Loop {
+        size_t start = 0;
+        // Переходы за конец цикла, адрес которых станет известен в EndLoop
+        std::vector<size_t> breaks;
+    };
+
+    Program& program_;
+    Chunk* chunk_;
+    std::vector<Loop> loops_;
+};
+
+// Компилирует дерево, полученное из ParseProgram, в байт-код
+Program Compile(runtime::Executable& program);
+
+}  // namespace bytecode
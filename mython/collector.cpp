@@ -0,0 +1,125 @@
+#include "collector.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace runtime {
+
+void TrackInstance(ClassInstance& instance) {
+    CycleCollector::Instance().Track(instance);
+}
+
+CycleCollector& CycleCollector::Instance() {
+    thread_local CycleCollector collector;
+    return collector;
+}
+
+CycleCollector::CycleCollector() {
+    head_.prev_ = head_.next_ = &head_;
+}
+
+CycleCollector::~CycleCollector() {
+    while (head_.next_ != &head_) {
+        head_.next_->Unlink();
+    }
+    head_.prev_ = head_.next_ = nullptr;
+}
+
+void CycleCollector::Track(ClassInstance& instance) {
+    // Новый экземпляр ещё не принадлежит ни одному ObjectHolder, поэтому сборка выполняется
+    // до его включения в список
+    if (threshold_ != 0 && ++allocations_ >= threshold_ && !collecting_) {
+        Collect();
+    }
+
+    CollectorLink& link = instance.collector_link_;
+    link.owner_ = &instance;
+    link.prev_ = head_.prev_;
+    link.next_ = &head_;
+    head_.prev_->next_ = &link;
+    head_.prev_ = &link;
+}
+
+size_t CycleCollector::Collect() {
+    using Clock = chrono::steady_clock;
+    const auto start = Clock::now();
+    collecting_ = true;
+    allocations_ = 0;
+
+    // Ссылки из полей отслеживаемых экземпляров вычитаются из счётчиков ссылок.
+    // Ненулевой остаток означает ссылку извне: из переменных, стека VM или кода на C++
+    size_t scanned = 0;
+    for (CollectorLink* link = head_.next_; link != &head_; link = link->next_) {
+        link->external_refs_ = link->owner_->GetRefCount();
+        link->reachable_ = false;
+        ++scanned;
+    }
+    for (CollectorLink* link = head_.next_; link != &head_; link = link->next_) {
+        for (const auto& field : link->owner_->fields_) {
+            if (ClassInstance* target = TrackedInstance(field.second)) {
+                --target->collector_link_.external_refs_;
+            }
+        }
+    }
+
+    // Всё, что достижимо из экземпляров со ссылками извне, остаётся в живых
+    vector<ClassInstance*> pending;
+    for (CollectorLink* link = head_.next_; link != &head_; link = link->next_) {
+        if (link->external_refs_ > 0) {
+            link->reachable_ = true;
+            pending.push_back(link->owner_);
+        }
+    }
+    while (!pending.empty()) {
+        ClassInstance* instance = pending.back();
+        pending.pop_back();
+        for (const auto& field : instance->fields_) {
+            ClassInstance* target = TrackedInstance(field.second);
+            if (target != nullptr && !target->collector_link_.reachable_) {
+                target->collector_link_.reachable_ = true;
+                pending.push_back(target);
+            }
+        }
+    }
+
+    // Недостижимые экземпляры удерживаются, пока очищаются их поля, и освобождаются все вместе
+    vector<ObjectHolder> garbage;
+    for (CollectorLink* link = head_.next_; link != &head_; link = link->next_) {
+        if (!link->reachable_) {
+            garbage.push_back(ObjectHolder::Share(*link->owner_));
+        }
+    }
+    for (ObjectHolder& instance : garbage) {
+        static_cast<ClassInstance&>(*instance).fields_.clear();
+    }
+    const size_t freed = garbage.size();
+    garbage.clear();
+
+    collecting_ = false;
+    const auto pause = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start);
+    ++stats_.collections;
+    stats_.scanned += scanned;
+    stats_.freed += freed;
+    stats_.last_pause = pause;
+    stats_.total_pause += pause;
+    return freed;
+}
+
+size_t CycleCollector::GetTrackedCount() const {
+    size_t count = 0;
+    for (const CollectorLink* link = head_.next_; link != &head_; link = link->next_) {
+        ++count;
+    }
+    return count;
+}
+
+ClassInstance* CycleCollector::TrackedInstance(const ObjectHolder& value) {
+    if (value.GetKind() != ObjectKind::ClassInstance || value.IsBorrowed()) {
+        return nullptr;
+    }
+    auto* instance = static_cast<ClassInstance*>(value.Get());
+    return instance->collector_link_.IsLinked() ? instance : nullptr;
+}
+
+}  // namespace runtime
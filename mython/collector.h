@@ -0,0 +1,85 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <chrono>
+#include <cstddef>
+
+namespace runtime {
+
+// Статистика сборщика циклов
+struct CollectorStats {
+    // Число выполненных сборок
+    size_t collections = 0;
+    // Экземпляры, просмотренные всеми сборками
+    size_t scanned = 0;
+    // Экземпляры, освобождённые всеми сборками
+    size_t freed = 0;
+    // Длительность последней сборки и всех сборок вместе
+    std::chrono::nanoseconds last_pause{0};
+    std::chrono::nanoseconds total_pause{0};
+};
+
+/*
+ * Сборщик циклов между экземплярами классов.
+ * Счётчик ссылок не освобождает экземпляры, ссылающиеся друг на друга через поля
+ * (например, a.peer = b и b.peer = a). Сборщик отслеживает все экземпляры, размещённые в куче,
+ * и методом пробного удаления находит те, на которые нет ссылок, кроме ссылок из полей
+ * других отслеживаемых экземпляров, и которые недостижимы из остальных экземпляров.
+ * У найденных экземпляров очищаются поля, после чего счётчик ссылок освобождает их.
+ *
+ * Сборка выполняется по запросу функцией Collect либо автоматически после каждых
+ * GetThreshold() размещений экземпляров. У каждого потока свой сборщик: как и счётчик ссылок
+ * без MYTHON_ATOMIC_REFCOUNT, он рассчитан на то, что объекты не передаются между потоками
+ */
+class CycleCollector {
+public:
+    // Порог автоматической сборки по умолчанию
+    static constexpr size_t DEFAULT_THRESHOLD = 10000;
+
+    // Возвращает сборщик текущего потока
+    [[nodiscard]] static CycleCollector& Instance();
+
+    CycleCollector(const CycleCollector&) = delete;
+    CycleCollector& operator=(const CycleCollector&) = delete;
+
+    // Экземпляры, остающиеся в живых, перестают отслеживаться
+    ~CycleCollector();
+
+    // Начинает отслеживать экземпляр, размещённый в куче. Перед этим может выполнить сборку
+    void Track(ClassInstance& instance);
+
+    // Освобождает недостижимые циклы экземпляров и возвращает число освобождённых экземпляров
+    size_t Collect();
+
+    // Задаёт число размещений экземпляров между автоматическими сборками, 0 отключает их
+    void SetThreshold(size_t threshold) {
+        threshold_ = threshold;
+    }
+
+    [[nodiscard]] size_t GetThreshold() const {
+        return threshold_;
+    }
+
+    // Возвращает число отслеживаемых экземпляров
+    [[nodiscard]] size_t GetTrackedCount() const;
+
+    [[nodiscard]] const CollectorStats& GetStats() const {
+        return stats_;
+    }
+
+private:
+    CycleCollector();
+
+    // Возвращает отслеживаемый экземпляр, которым владеет value, либо nullptr
+    static ClassInstance* TrackedInstance(const ObjectHolder& value);
+
+    // Фиктивное звено, с которого начинается и которым заканчивается кольцевой список
+    CollectorLink head_;
+    size_t threshold_ = DEFAULT_THRESHOLD;
+    size_t allocations_ = 0;
+    bool collecting_ = false;
+    CollectorStats stats_;
+};
+
+}  // namespace runtime
@@ -0,0 +1,173 @@
+#include "gc.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+thread_local GcHeap* current_heap = nullptr;
+}  // namespace
+
+bool AdoptObject(Object& object) {
+    if (current_heap == nullptr) {
+        return false;
+    }
+    current_heap->Adopt(object);
+    return true;
+}
+
+GcHeap::~GcHeap() {
+    Destroy(objects_);
+}
+
+GcHeap::Scope::Scope(GcHeap& heap)
+    : previous_(current_heap) {
+    current_heap = &heap;
+}
+
+GcHeap::Scope::~Scope() {
+    current_heap = previous_;
+}
+
+GcHeap::Root::Root(GcHeap& heap, const Closure& closure)
+    : heap_(heap)
+    , closure_(closure) {
+    heap_.roots_.push_back(&closure_);
+}
+
+GcHeap::Root::~Root() {
+    auto& roots = heap_.roots_;
+    roots.erase(find(roots.rbegin(), roots.rend(), &closure_).base() - 1);
+}
+
+GcHeap::Pin::Pin(const ObjectHolder& value)
+    : heap_(current_heap)
+    , is_array_(false) {
+    if (heap_ != nullptr) {
+        heap_->pinned_values_.push_back(&value);
+    }
+}
+
+GcHeap::Pin::Pin(const vector<ObjectHolder>& values)
+    : heap_(current_heap)
+    , is_array_(true) {
+    if (heap_ != nullptr) {
+        heap_->pinned_arrays_.push_back(&values);
+    }
+}
+
+GcHeap::Pin::~Pin() {
+    // Pin создаются и разрушаются в порядке стека, поэтому закреплённое значение - последнее
+    if (heap_ == nullptr) {
+        return;
+    }
+    if (is_array_) {
+        heap_->pinned_arrays_.pop_back();
+    } else {
+        heap_->pinned_values_.pop_back();
+    }
+}
+
+GcHeap* GcHeap::GetCurrent() {
+    return current_heap;
+}
+
+void GcHeap::SafePoint() {
+    GcHeap* heap = current_heap;
+    if (heap != nullptr && heap->threshold_ != 0 && heap->allocations_ >= heap->threshold_) {
+        heap->Collect();
+    }
+}
+
+void GcHeap::Adopt(Object& object) {
+    object.header_.SetManaged();
+    objects_.push_back(&object);
+    ++allocations_;
+}
+
+size_t GcHeap::Collect() {
+    using Clock = chrono::steady_clock;
+    const auto start = Clock::now();
+    allocations_ = 0;
+
+    // Пометка: обход полей экземпляров, достижимых из корней
+    vector<ClassInstance*> pending;
+    for (const Closure* root : roots_) {
+        for (const auto& [name, value] : *root) {
+            Mark(value, pending);
+        }
+        for (const ObjectHolder& value : root->GetFrame()) {
+            Mark(value, pending);
+        }
+    }
+    for (const ObjectHolder* value : pinned_values_) {
+        Mark(*value, pending);
+    }
+    for (const vector<ObjectHolder>* values : pinned_arrays_) {
+        for (const ObjectHolder& value : *values) {
+            Mark(value, pending);
+        }
+    }
+    while (!pending.empty()) {
+        ClassInstance* instance = pending.back();
+        pending.pop_back();
+        for (const auto& field : instance->fields_) {
+            Mark(field.second, pending);
+        }
+    }
+
+    // Очистка: неотмеченные объекты кучи освобождаются, отметки остальных снимаются
+    const auto garbage_begin = stable_partition(objects_.begin(), objects_.end(), [](const Object* object) {
+        return object->header_.IsMarked();
+    });
+    const vector<Object*> garbage(garbage_begin, objects_.end());
+    objects_.erase(garbage_begin, objects_.end());
+    Destroy(garbage);
+
+    for (Object* object : marked_) {
+        object->header_.SetMarked(false);
+    }
+
+    const auto pause = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start);
+    ++stats_.collections;
+    stats_.marked += marked_.size();
+    stats_.freed += garbage.size();
+    stats_.last_pause = pause;
+    stats_.total_pause += pause;
+    marked_.clear();
+    return garbage.size();
+}
+
+void GcHeap::Mark(const ObjectHolder& value, vector<ClassInstance*>& pending) {
+    const ObjectKind kind = value.GetKind();
+    // ObjectHolder::Own хранит числа и логические значения внутри ObjectHolder, а не в куче
+    if (kind == ObjectKind::None || kind == ObjectKind::Number || kind == ObjectKind::Bool) {
+        return;
+    }
+
+    Object* object = value.Get();
+    const bool is_instance = kind == ObjectKind::ClassInstance;
+    if ((!is_instance && !object->header_.IsManaged()) || object->header_.IsMarked()) {
+        return;
+    }
+    object->header_.SetMarked(true);
+    marked_.push_back(object);
+    if (is_instance) {
+        pending.push_back(static_cast<ClassInstance*>(object));
+    }
+}
+
+void GcHeap::Destroy(const vector<Object*>& objects) {
+    for (Object* object : objects) {
+        if (object->GetKind() == ObjectKind::ClassInstance) {
+            static_cast<ClassInstance*>(object)->fields_.clear();
+        }
+    }
+    for (Object* object : objects) {
+        delete object;
+    }
+}
+
+}  // namespace runtime
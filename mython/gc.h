@@ -0,0 +1,161 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace runtime {
+
+// Способ управления памятью объектов, создаваемых при исполнении программы
+enum class MemoryMode {
+    RefCounting,  // счётчик ссылок и сборщик циклов CycleCollector
+    TracingGc,    // куча GcHeap со сборкой мусора пометкой и очисткой
+};
+
+#ifndef MYTHON_TRACING_GC
+#define MYTHON_TRACING_GC 0
+#endif
+
+// Способ управления памятью по умолчанию. Сборка с MYTHON_TRACING_GC=1 выбирает кучу GcHeap
+inline constexpr MemoryMode DEFAULT_MEMORY_MODE =
+    MYTHON_TRACING_GC ? MemoryMode::TracingGc : MemoryMode::RefCounting;
+
+// Статистика кучи GcHeap
+struct GcStats {
+    // Число выполненных сборок
+    size_t collections = 0;
+    // Объекты, отмеченные достижимыми во всех сборках
+    size_t marked = 0;
+    // Объекты, освобождённые всеми сборками
+    size_t freed = 0;
+    // Длительность последней сборки и всех сборок вместе
+    std::chrono::nanoseconds last_pause{0};
+    std::chrono::nanoseconds total_pause{0};
+};
+
+/*
+ * Куча объектов с трассирующей сборкой мусора - альтернатива счётчику ссылок.
+ * Пока куча текущая (см. GcHeap::Scope), объекты, размещаемые ObjectHolder::Own, принадлежат ей:
+ * их счётчик ссылок бессмертен, поэтому копирование ObjectHolder не меняет счётчик, а объект
+ * освобождается сборкой мусора либо вместе с кучей. Объекты, созданные вне кучи (например,
+ * классы и константы, созданные при разборе), по-прежнему управляются счётчиком ссылок.
+ *
+ * Сборка отмечает объекты, достижимые из корней, и освобождает неотмеченные. Корни - таблицы
+ * символов, зарегистрированные через GcHeap::Root, и промежуточные значения, закреплённые
+ * через GcHeap::Pin. ast::Program и VM регистрируют таблицу символов программы, вызов метода -
+ * таблицу символов своего кадра, а узлы дерева и VM закрепляют вычисленные операнды, пока
+ * вычисляются следующие. Сборка выполняется только в безопасных точках - между инструкциями
+ * верхнего уровня, перед каждой итерацией цикла и при входе в метод.
+ * Значения кучи, которые хранит код на C++ вне корней, действительны до ближайшей безопасной точки.
+ * Куча должна быть разрушена после всех ObjectHolder, ссылающихся на её объекты
+ */
+class GcHeap {
+public:
+    // Число размещений между сборками по умолчанию
+    static constexpr size_t DEFAULT_THRESHOLD = 10000;
+
+    GcHeap() = default;
+    GcHeap(const GcHeap&) = delete;
+    GcHeap& operator=(const GcHeap&) = delete;
+
+    // Освобождает все объекты кучи
+    ~GcHeap();
+
+    // Делает кучу текущей в пределах своей области видимости
+    class Scope {
+    public:
+        explicit Scope(GcHeap& heap);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GcHeap* previous_;
+    };
+
+    // Регистрирует таблицу символов как корень кучи в пределах своей области видимости
+    class Root {
+    public:
+        Root(GcHeap& heap, const Closure& closure);
+        ~Root();
+
+        Root(const Root&) = delete;
+        Root& operator=(const Root&) = delete;
+
+    private:
+        GcHeap& heap_;
+        const Closure& closure_;
+    };
+
+    // Закрепляет значение или массив значений, хранящиеся вне корней, в текущей куче потока
+    // в пределах своей области видимости. Без текущей кучи ничего не делает.
+    // Массив закрепляется целиком, включая элементы, добавленные после создания Pin
+    class Pin {
+    public:
+        explicit Pin(const ObjectHolder& value);
+        explicit Pin(const std::vector<ObjectHolder>& values);
+        ~Pin();
+
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+
+    private:
+        GcHeap* heap_;
+        bool is_array_;
+    };
+
+    // Возвращает текущую кучу потока либо nullptr
+    [[nodiscard]] static GcHeap* GetCurrent();
+
+    // Безопасная точка: выполняет сборку в текущей куче, если с прошлой сборки размещено
+    // не меньше GetThreshold() объектов
+    static void SafePoint();
+
+    // Передаёт куче объект, только что размещённый в куче процесса
+    void Adopt(Object& object);
+
+    // Освобождает объекты, недостижимые из корней, и возвращает их число.
+    // Вызывается только в безопасной точке
+    size_t Collect();
+
+    // Задаёт число размещений между сборками в безопасных точках, 0 отключает их
+    void SetThreshold(size_t threshold) {
+        threshold_ = threshold;
+    }
+
+    [[nodiscard]] size_t GetThreshold() const {
+        return threshold_;
+    }
+
+    // Возвращает число объектов кучи
+    [[nodiscard]] size_t GetObjectCount() const {
+        return objects_.size();
+    }
+
+    [[nodiscard]] const GcStats& GetStats() const {
+        return stats_;
+    }
+
+private:
+    // Отмечает объект value, если это объект кучи или экземпляр класса, поля которого нужно обойти
+    void Mark(const ObjectHolder& value, std::vector<ClassInstance*>& pending);
+    // Разрушает объекты, сначала очищая поля экземпляров, чтобы ни один деструктор
+    // не обращался к уже освобождённому объекту
+    static void Destroy(const std::vector<Object*>& objects);
+
+    std::vector<Object*> objects_;
+    std::vector<const Closure*> roots_;
+    // Значения и массивы, закреплённые через Pin
+    std::vector<const ObjectHolder*> pinned_values_;
+    std::vector<const std::vector<ObjectHolder>*> pinned_arrays_;
+    // Объекты, отмеченные текущей сборкой
+    std::vector<Object*> marked_;
+    size_t threshold_ = DEFAULT_THRESHOLD;
+    size_t allocations_ = 0;
+    GcStats stats_;
+};
+
+}  // namespace runtime
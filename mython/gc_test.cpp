@@ -0,0 +1,173 @@
+#include "bytecode.h"
+#include "gc.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+#include "test_runner_p.h"
+#include "vm.h"
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string PAIRS = R"(
+class Pair:
+  def __init__(name):
+    self.name = name
+
+  def link(other):
+    self.peer = other
+    other.peer = self
+
+keep = Pair('kept')
+keep.link(Pair('peer'))
+p = Pair('a')
+p.link(Pair('b'))
+p = Pair('c')
+p.link(Pair('d'))
+p = Pair('e')
+p.link(Pair('f'))
+print keep.name, keep.peer.name, keep.peer.peer.name, p.peer.name
+)"s;
+
+string Run(const string& program, GcHeap& heap, bool use_vm) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    GcHeap::Scope scope(heap);
+    DummyContext context;
+    Closure closure;
+    if (use_vm) {
+        bytecode::Program code = bytecode::Compile(*tree);
+        VM(code).Run(closure, context);
+    } else {
+        tree->Execute(closure, context);
+    }
+    return context.output.str();
+}
+
+void TestGcProgramOutput() {
+    for (const bool use_vm : {false, true}) {
+        GcHeap heap;
+        heap.SetThreshold(1);
+        ASSERT_EQUAL(Run(PAIRS, heap, use_vm), "kept peer kept f\n"s);
+        // Пары a-b и c-d стали недостижимы, хотя ссылаются друг на друга
+        ASSERT(heap.GetStats().collections > 0);
+        ASSERT_EQUAL(heap.GetStats().freed, 4U);
+    }
+}
+
+void TestGcTopLevelLoop() {
+    // Сборка выполняется между итерациями цикла, а не только после него
+    const string program = R"(
+class Pair:
+  def link(other):
+    self.peer = other
+    other.peer = self
+
+i = 0
+while i < 100:
+  p = Pair()
+  p.link(Pair())
+  i = i + 1
+print i
+)"s;
+    for (const bool use_vm : {false, true}) {
+        GcHeap heap;
+        heap.SetThreshold(10);
+        ASSERT_EQUAL(Run(program, heap, use_vm), "100\n"s);
+        ASSERT(heap.GetStats().collections >= 10U);
+        ASSERT(heap.GetObjectCount() < 20U);
+    }
+}
+
+void TestGcMethodLoop() {
+    // Кадры методов - корни кучи, а цикл внутри метода проходит безопасные точки, поэтому
+    // число живых объектов не растёт вместе с числом итераций. Промежуточные значения выражений
+    // (аргумент make('left') и левый операнд сложения) переживают сборки во время churn
+    const string program = R"(
+class Node:
+  def link(other):
+    self.peer = other
+    other.peer = self
+
+class Factory:
+  def make(name):
+    node = Node()
+    node.name = name
+    return node
+
+  def name_of(node, count):
+    return node.name + str(count)
+
+  def churn(n):
+    i = 0
+    while i < n:
+      a = Node()
+      a.link(Node())
+      i = i + 1
+    return i
+
+f = Factory()
+print f.churn(2000)
+print f.name_of(f.make('left'), f.churn(300)), f.name_of(f.make('a'), 0) + str(f.churn(300))
+)"s;
+    for (const bool use_vm : {false, true}) {
+        GcHeap heap;
+        heap.SetThreshold(50);
+        ASSERT_EQUAL(Run(program, heap, use_vm), "2000\nleft300 a0300\n"s);
+        ASSERT(heap.GetStats().collections >= 100U);
+        ASSERT(heap.GetStats().freed >= 5000U);
+        ASSERT(heap.GetObjectCount() < 100U);
+    }
+}
+
+void TestGcRootsAndLifetime() {
+    Class cls{"Node"s, {}, nullptr};
+    GcHeap heap;
+    heap.SetThreshold(0);
+    Closure closure;
+    GcHeap::Root root(heap, closure);
+    {
+        GcHeap::Scope scope(heap);
+        auto kept = ObjectHolder::Own(ClassInstance{cls});
+        auto lost = ObjectHolder::Own(ClassInstance{cls});
+        kept.TryAs<ClassInstance>()->Fields()["name"s] = ObjectHolder::Own(String{"kept"s});
+        lost.TryAs<ClassInstance>()->Fields()["me"s] = lost;
+        closure["kept"s] = kept;
+        // Копирование ObjectHolder не меняет счётчик ссылок объектов кучи
+        ASSERT_EQUAL(kept->GetRefCount(), ObjectHeader::IMMORTAL_REFS);
+    }
+    ASSERT_EQUAL(heap.GetObjectCount(), 3U);
+
+    // Объекты, созданные вне кучи, по-прежнему управляются счётчиком ссылок
+    auto outside = ObjectHolder::Own(String{"outside"s});
+    ASSERT_EQUAL(outside->GetRefCount(), 1U);
+    closure["outside"s] = outside;
+
+    ASSERT_EQUAL(heap.Collect(), 1U);
+    ASSERT_EQUAL(heap.GetObjectCount(), 2U);
+    auto* kept = closure.at("kept"s).TryAs<ClassInstance>();
+    ASSERT_EQUAL(kept->Fields().at("name"s).TryAs<String>()->GetValue(), "kept"s);
+    ASSERT_EQUAL(outside->GetRefCount(), 2U);
+
+    closure.erase("kept"s);
+    ASSERT_EQUAL(heap.Collect(), 2U);
+    ASSERT_EQUAL(heap.GetObjectCount(), 0U);
+    ASSERT_EQUAL(heap.GetStats().collections, 2U);
+    ASSERT_EQUAL(heap.GetStats().freed, 3U);
+}
+
+}  // namespace
+
+void RunGcTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestGcProgramOutput);
+    RUN_TEST(tr, runtime::TestGcTopLevelLoop);
+    RUN_TEST(tr, runtime::TestGcMethodLoop);
+    RUN_TEST(tr, runtime::TestGcRootsAndLifetime);
+}
+
+}  // namespace runtime
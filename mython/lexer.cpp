@@ -1,15 +1,110 @@
 #include "lexer.h"
 
 #include <algorithm>
+#include <array>
 #include <charconv>
-#include <unordered_map>
+#include <cstdint>
 #include <iostream>
-#include <set>
+#include <limits>
+#include <system_error>
+#include <thread>
 
 using namespace std;
 
 namespace parse {
 
+namespace {
+
+// Класс символа определяет, какая лексема с него начинается
+enum class CharClass : uint8_t {
+    Invalid,     // недопустимый символ
+    Letter,      // начало идентификатора или ключевого слова: [A-Za-z_]
+    Digit,       // начало числа
+    Operator,    // односимвольная лексема, возможно, продолжающаяся символом '='
+    Newline,     // конец строки
+    Comment,     // начало комментария '#'
+    Quote,       // начало строковой константы
+};
+
+constexpr std::array<CharClass, 256> CHAR_CLASSES = [] {
+    std::array<CharClass, 256> classes{};
+    for (int c = 'a'; c <= 'z'; ++c) {
+        classes[c] = CharClass::Letter;
+        classes[c - 'a' + 'A'] = CharClass::Letter;
+    }
+    classes['_'] = CharClass::Letter;
+    for (int c = '0'; c <= '9'; ++c) {
+        classes[c] = CharClass::Digit;
+    }
+    for (const char c : {'+', '-', '*', '/', '=', '>', '<', '!', '(', ')', '.', ':', ','}) {
+        classes[static_cast<unsigned char>(c)] = CharClass::Operator;
+    }
+    classes['\n'] = CharClass::Newline;
+    classes['#'] = CharClass::Comment;
+    classes['"'] = CharClass::Quote;
+    classes['\''] = CharClass::Quote;
+    return classes;
+}();
+
+CharClass GetCharClass(char c) {
+    return CHAR_CLASSES[static_cast<unsigned char>(c)];
+}
+
+template <typename T>
+Token MakeToken() {
+    return T{};
+}
+
+struct Keyword {
+    std::string_view text;
+    Token (*make)() = nullptr;
+};
+
+constexpr Keyword KEYWORDS[] = {
+    {"class"sv, MakeToken<token_type::Class>},   {"return"sv, MakeToken<token_type::Return>},
+    {"if"sv, MakeToken<token_type::If>},         {"else"sv, MakeToken<token_type::Else>},
+    {"def"sv, MakeToken<token_type::Def>},       {"while"sv, MakeToken<token_type::While>},
+    {"break"sv, MakeToken<token_type::Break>},   {"continue"sv, MakeToken<token_type::Continue>},
+    {"print"sv, MakeToken<token_type::Print>},   {"and"sv, MakeToken<token_type::And>},
+    {"or"sv, MakeToken<token_type::Or>},         {"not"sv, MakeToken<token_type::Not>},
+    {"None"sv, MakeToken<token_type::None>},     {"True"sv, MakeToken<token_type::True>},
+    {"False"sv, MakeToken<token_type::False>},
+};
+
+constexpr size_t KEYWORD_TABLE_SIZE = 32;
+constexpr size_t MIN_KEYWORD_LENGTH = 2;
+constexpr size_t MAX_KEYWORD_LENGTH = 8;
+
+// Совершенная хеш-функция ключевых слов: по длине, первому и последнему символу
+// каждое ключевое слово получает свою ячейку таблицы
+constexpr size_t KeywordHash(std::string_view word) {
+    return (2 * word.size() + static_cast<unsigned char>(word.front())
+            + static_cast<unsigned char>(word.back()))
+         % KEYWORD_TABLE_SIZE;
+}
+
+constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> KEYWORD_TABLE = [] {
+    std::array<Keyword, KEYWORD_TABLE_SIZE> table{};
+    for (const Keyword& keyword : KEYWORDS) {
+        table[KeywordHash(keyword.text)] = keyword;
+    }
+    return table;
+}();
+
+constexpr bool IsPerfectKeywordHash() {
+    for (const Keyword& keyword : KEYWORDS) {
+        if (KEYWORD_TABLE[KeywordHash(keyword.text)].text != keyword.text
+            || keyword.text.size() < MIN_KEYWORD_LENGTH
+            || keyword.text.size() > MAX_KEYWORD_LENGTH) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(IsPerfectKeywordHash(), "Keywords must not collide in KEYWORD_TABLE");
+
+}  // namespace
+
 bool operator==(const Token& lhs, const Token& rhs) {
     using namespace token_type;
 
@@ -56,6 +151,9 @@ std::ostream& operator<<(std::ostream& os, const Token& rhs) {
     UNVALUED_OUTPUT(If);
     UNVALUED_OUTPUT(Else);
     UNVALUED_OUTPUT(Def);
+    UNVALUED_OUTPUT(While);
+    UNVALUED_OUTPUT(Break);
+    UNVALUED_OUTPUT(Continue);
     UNVALUED_OUTPUT(Newline);
     UNVALUED_OUTPUT(Print);
     UNVALUED_OUTPUT(Indent);
@@ -77,192 +175,231 @@ std::ostream& operator<<(std::ostream& os, const Token& rhs) {
     return os << "Unknown token :("sv;
 }
 
-Lexer::Lexer(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    if (it == end) {
-        tokens_.emplace_back(token_type::Eof{});
-        return;
-    }
-
-    const std::set<char> chars = {'+', '-', '*', '/', '=', '>', '<', '!', '(', ')', '.', ':', ','};
+Lexer::Lexer(std::istream& input, LexerMode mode)
+    : mode_(mode)
+    , scanner_(scan::GetScanner())
+    , input_(&input) {
+    Start();
+}
 
-    int global_indent = 0;
-    int current_indent = 0;
-    bool is_new_line = true;
-    bool is_start_file = true;
+Lexer::Lexer(std::string_view source, LexerMode mode)
+    : mode_(mode)
+    , scanner_(scan::GetScanner())
+    , source_(source) {
+    Start();
+}
 
-    while (!input.eof()) {
+Lexer::~Lexer() {
+    StopProducer();
+}
 
-        while (input.peek() == ' ') {
+void Lexer::Start() {
+    if (mode_ == LexerMode::Pipelined) {
+        queue_ = make_unique<SpscQueue<Token>>(PIPELINE_CAPACITY);
+        producer_ = thread([this] {
+            Produce();
+        });
+    }
+    try {
+        // В обычном режиме весь текст разбивается на токены сразу
+        Fill(mode_ == LexerMode::Eager ? std::numeric_limits<size_t>::max() : 0);
+    } catch (...) {
+        // Деструктор не будет вызван, поэтому поток лексера останавливается здесь
+        StopProducer();
+        throw;
+    }
+}
 
-            input.get();
-            if (is_new_line) {
-                current_indent++;
-            }
-        }
-        if (input.peek() == '\n' && is_new_line) {
-            input.get();
-            continue;
+void Lexer::Fill(size_t index) {
+    if (queue_) {
+        while (tokens_.size() <= index
+               && (tokens_.empty() || !tokens_.back().Is<token_type::Eof>())) {
+            tokens_.push_back(Receive());
         }
+        return;
+    }
+    while (tokens_.size() <= index && !finished_) {
+        ScanLexeme();
+    }
+}
 
-        if (global_indent > current_indent) {
-            while (global_indent != current_indent) {
-                global_indent = global_indent - 2;
-                tokens_.emplace_back(token_type::Dedent{});
-            }
-        } else if (global_indent < current_indent) {
-            while (global_indent != current_indent) {
-                global_indent = global_indent + 2;
-                tokens_.emplace_back(token_type::Indent{});
-            }
+bool Lexer::Refill() {
+    if (input_ != nullptr && !at_eof_) {
+        const size_t old_size = buffer_.size();
+        buffer_.resize(old_size + CHUNK_SIZE);
+        input_->read(buffer_.data() + old_size, CHUNK_SIZE);
+        buffer_.resize(old_size + static_cast<size_t>(input_->gcount()));
+        source_ = buffer_;
+        if (buffer_.size() > old_size) {
+            return true;
         }
-        if (std::isalpha(input.peek()) || input.peek() == '_') {
-
-
-            std::string tmp_token;
-
-            tmp_token += static_cast<char>(input.get());
-
-            while ((std::isalpha(input.peek()) || input.peek() == '_' || std::isdigit(input.peek())) && !input.eof()) {
-                tmp_token += static_cast<char>(input.get());
-            }
-
-            if (ParseKeyLexem(tmp_token)) {
-
-                is_new_line = false;
-                is_start_file = false;
-                continue;
-            }
-            ParseIdLexem(tmp_token);
-            is_new_line = false;
-            is_start_file = false;
-        } else if (std::isdigit(input.peek())) {
-            std::string tmp_token;
+    }
+    at_eof_ = true;
+    return false;
+}
 
-            tmp_token += static_cast<char>(input.get());
+int Lexer::Peek() {
+    if (pos_ < source_.size() || Refill()) {
+        return static_cast<unsigned char>(source_[pos_]);
+    }
+    return END;
+}
 
-            while (std::isdigit(input.peek())) {
-                tmp_token += static_cast<char>(input.get());
-            }
+template <typename Scan>
+void Lexer::SkipWith(Scan scan) {
+    for (;;) {
+        const char* const begin = source_.data();
+        const char* const end = begin + source_.size();
+        const char* const p = scan(begin + pos_, end);
+        pos_ = static_cast<size_t>(p - begin);
+        if (p != end || !Refill()) {
+            return;
+        }
+    }
+}
 
-            ParseDigitLexem(tmp_token);
-            is_new_line = false;
-            is_start_file = false;
-        } else if (char c = input.peek(); chars.find(c) != chars.end()) {
-            ParseCharLexem(static_cast<char>(input.get()), input);
-            is_new_line = false;
-            is_start_file = false;
-        } else if (input.peek() == '\n') {
-            input.get();
-            if (is_start_file) {
-                continue;
-            }
-            if (is_new_line) {
-                continue;
-            }
-            tokens_.emplace_back(token_type::Newline{});
-            is_new_line = true;
-            current_indent = 0;
-        } else if (input.peek() == '#') {
+void Lexer::ScanLexeme() {
+    // Текст, прочитанный из потока и уже разобранный, больше не нужен
+    if (input_ != nullptr && pos_ >= CHUNK_SIZE) {
+        buffer_.erase(0, pos_);
+        source_ = buffer_;
+        pos_ = 0;
+    }
 
-            input.get();
+    // Как и чтение из istream, попытка прочитать символ за концом текста отмечает его окончание,
+    // и разбор завершается в начале следующей лексемы
+    if (at_eof_) {
+        if (needs_newline_) {
+            Emit(token_type::Newline{});
+        }
+        Emit(token_type::Eof{});
+        return;
+    }
 
+    const size_t spaces_start = pos_;
+    SkipWith(scanner_.skip_spaces);
+    if (is_new_line_) {
+        current_indent_ += static_cast<int>(pos_ - spaces_start);
+    }
+    if (Peek() == '\n' && is_new_line_) {
+        ++pos_;
+        return;
+    }
 
-            while (input.peek() != '\n' && !input.eof()) {
+    if (global_indent_ > current_indent_) {
+        while (global_indent_ != current_indent_) {
+            global_indent_ = global_indent_ - 2;
+            Emit(token_type::Dedent{});
+        }
+    } else if (global_indent_ < current_indent_) {
+        while (global_indent_ != current_indent_) {
+            global_indent_ = global_indent_ + 2;
+            Emit(token_type::Indent{});
+        }
+    }
 
-                input.get();
-            }
-            is_start_file = false;
-        } else if (input.peek() == '\"') {
-            input.get();
-            std::string str;
-            while (input.peek() != '\"') {
-                if (input.peek() == '\\') {
-                    input.get();
-                    if (input.peek() == 't') {
-                        input.get();
-                        str += '\t';
-                    } else if (input.peek() == 'n') {
-                        input.get();
-                        str += '\n';
-                    } else if (input.peek() == '\\') {
-                        input.get();
-                        str += '\\';
-                    } else if (input.peek() == 'r') {
-                        input.get();
-                        str += '\r';
-                    } else if (input.peek() == '\"') {
-                        input.get();
-                        str += '\"';
-                    } else if (input.peek() == '\'') {
-                        input.get();
-                        str += '\'';
-                    }
-                } else {
-                    str += input.get();
-                }
+    const int c = Peek();
+    if (c == END) {
+        return;
+    }
+    switch (GetCharClass(static_cast<char>(c))) {
+        case CharClass::Letter: {
+            const size_t start = pos_++;
+            SkipWith(scanner_.skip_identifier);
+            const std::string_view lexeme = source_.substr(start, pos_ - start);
+            if (!ParseKeyLexem(lexeme)) {
+                ParseIdLexem(lexeme);
             }
-            input.get();
-            tokens_.emplace_back(token_type::String{str});
-            is_new_line = false;
-            is_start_file = false;
-        } else if (input.peek() == '\'') {
-            input.get();
-            std::string str;
-            while (input.peek() != '\'') {
-                if (input.peek() == '\\') {
-                    input.get();
-                    if (input.peek() == 't') {
-                        input.get();
-                        str += '\t';
-                    } else if (input.peek() == 'n') {
-                        input.get();
-                        str += '\n';
-                    } else if (input.peek() == '\\') {
-                        input.get();
-                        str += '\\';
-                    } else if (input.peek() == 'r') {
-                        input.get();
-                        str += '\r';
-                    } else if (input.peek() == '\"') {
-                        input.get();
-                        str += '\"';
-                    } else if (input.peek() == '\'') {
-                        input.get();
-                        str += '\'';
-                    }
-                } else {
-                    str += input.get();
+            break;
+        }
+        case CharClass::Digit: {
+            const size_t start = pos_++;
+            SkipWith([](const char* p, const char* end) {
+                while (p != end && GetCharClass(*p) == CharClass::Digit) {
+                    ++p;
                 }
-            }
-            input.get();
-            tokens_.emplace_back(token_type::String{str});
-            is_new_line = false;
-            is_start_file = false;
+                return p;
+            });
+            ParseDigitLexem(source_.substr(start, pos_ - start));
+            break;
         }
-
+        case CharClass::Operator:
+            ++pos_;
+            ParseCharLexem(static_cast<char>(c));
+            break;
+        case CharClass::Newline:
+            ++pos_;
+            if (is_start_file_ || is_new_line_) {
+                return;
+            }
+            Emit(token_type::Newline{});
+            is_new_line_ = true;
+            current_indent_ = 0;
+            return;
+        case CharClass::Comment:
+            SkipWith(scanner_.find_line_end);
+            is_start_file_ = false;
+            return;
+        case CharClass::Quote:
+            ++pos_;
+            ParseStringLexem(static_cast<char>(c));
+            break;
+        case CharClass::Invalid:
+            throw LexerError("Unexpected character '"s + static_cast<char>(c) + "'"s);
     }
+    is_new_line_ = false;
+    is_start_file_ = false;
+}
 
+void Lexer::Emit(Token token) {
+    needs_newline_ = !token.Is<token_type::Newline>() && !token.Is<token_type::Dedent>()
+                  && !token.Is<token_type::Indent>();
+    finished_ = token.Is<token_type::Eof>();
+    if (queue_) {
+        Send(std::move(token));
+    } else {
+        tokens_.push_back(std::move(token));
+    }
+}
 
-
-    if (tokens_.size() != 0) {
-        if (tokens_.back() != token_type::Newline{} && tokens_.back() != token_type::Dedent{} && tokens_.back() != token_type::Indent{}) {
-            tokens_.emplace_back(token_type::Newline{});
+void Lexer::Produce() {
+    try {
+        while (!finished_) {
+            ScanLexeme();
+        }
+    } catch (const ProducerStopped&) {
+    } catch (...) {
+        producer_error_ = current_exception();
+        try {
+            Send(token_type::Eof{});
+        } catch (const ProducerStopped&) {
         }
     }
+}
 
+void Lexer::Send(Token token) {
+    if (!queue_->Push(std::move(token))) {
+        throw ProducerStopped{};
+    }
+}
 
+Token Lexer::Receive() {
+    Token token;
+    queue_->Pop(token);
+    if (token.Is<token_type::Eof>() && producer_error_) {
+        // Ошибка выбрасывается на том же токене, что и при разборе без отдельного потока,
+        // а следующие вызовы NextToken возвращают token_type::Eof
+        tokens_.push_back(std::move(token));
+        rethrow_exception(producer_error_);
+    }
+    return token;
+}
 
-
-    tokens_.emplace_back(token_type::Eof{});
-
-    /*for (auto& token : tokens_) {
-        cout << token << endl;
-    }*/
-
-    max_token_ = tokens_.size() - 1;
-
+void Lexer::StopProducer() {
+    if (producer_.joinable()) {
+        queue_->Close();
+        producer_.join();
+    }
 }
 
 const Token& Lexer::CurrentToken() const {
@@ -270,95 +407,118 @@ const Token& Lexer::CurrentToken() const {
 }
 
 const Token& Lexer::NextToken() {
-    if (current_token_ < max_token_) {
-        return tokens_[++current_token_];
-    } else {
-        return tokens_[max_token_];
+    if (tokens_[current_token_].Is<token_type::Eof>()) {
+        return tokens_[current_token_];
     }
-}
 
-bool Lexer::ParseKeyLexem(const std::string& lexem) {
-    if (lexem == "class") {
-        tokens_.emplace_back(token_type::Class{});
-    } else if (lexem == "return") {
-        tokens_.emplace_back(token_type::Return{});
-    } else if (lexem == "if") {
-        tokens_.emplace_back(token_type::If{});
-    } else if (lexem == "else") {
-        tokens_.emplace_back(token_type::Else{});
-    } else if (lexem == "def") {
-        tokens_.emplace_back(token_type::Def{});
-    } else if (lexem == "print") {
-        tokens_.emplace_back(token_type::Print{});
-    } else if (lexem == "and") {
-        tokens_.emplace_back(token_type::And{});
-    } else if (lexem == "or") {
-        tokens_.emplace_back(token_type::Or{});
-    } else if (lexem == "not") {
-        tokens_.emplace_back(token_type::Not{});
-    } else if (lexem == "==") {
-        tokens_.emplace_back(token_type::Eq{});
-    } else if (lexem == "!=") {
-        tokens_.emplace_back(token_type::NotEq{});
-    } else if (lexem == "<=") {
-        tokens_.emplace_back(token_type::LessOrEq{});
-    } else if (lexem == ">=") {
-        tokens_.emplace_back(token_type::GreaterOrEq{});
-    } else if (lexem == "None") {
-        tokens_.emplace_back(token_type::None{});
-    } else if (lexem == "True") {
-        tokens_.emplace_back(token_type::True{});
-    } else if (lexem == "False") {
-
-        tokens_.emplace_back(token_type::False{});
+    ++current_token_;
+    if (mode_ != LexerMode::Eager) {
+        // Предыдущий токен остаётся в буфере: ссылка на него могла быть получена до вызова NextToken
+        while (current_token_ > 1) {
+            tokens_.pop_front();
+            --current_token_;
+        }
+    }
+    Fill(current_token_);
+    return tokens_[current_token_];
+}
 
-    } else {
+bool Lexer::ParseKeyLexem(std::string_view lexem) {
+    // Идентификатор сравнивается не более чем с одним ключевым словом
+    if (lexem.size() < MIN_KEYWORD_LENGTH || lexem.size() > MAX_KEYWORD_LENGTH) {
         return false;
     }
-
+    const Keyword& keyword = KEYWORD_TABLE[KeywordHash(lexem)];
+    if (keyword.text != lexem) {
+        return false;
+    }
+    Emit(keyword.make());
     return true;
 }
 
-void Lexer::ParseIdLexem(const std::string& lexem) {
-    tokens_.emplace_back(token_type::Id{lexem});
+void Lexer::ParseIdLexem(std::string_view lexem) {
+    Emit(token_type::Id{lexem});
 }
 
-void Lexer::ParseDigitLexem(const std::string& lexem) {
-    int tmp_int = std::stoi(lexem);
-    tokens_.emplace_back(token_type::Number{tmp_int});
+void Lexer::ParseDigitLexem(std::string_view lexem) {
+    int value = 0;
+    if (std::from_chars(lexem.data(), lexem.data() + lexem.size(), value).ec != std::errc{}) {
+        throw LexerError("Number is out of range: "s + std::string(lexem));
+    }
+    Emit(token_type::Number{value});
 }
 
-void Lexer::ParseCharLexem(char lexem, istream& input) {
-    bool flag = true;
-    if (lexem == '!') {
-        if (input.peek() == '=') {
-            tokens_.emplace_back(token_type::NotEq{});
-            input.get();
-            flag = false;
-        }
-    } else if (lexem == '<') {
-        if (input.peek() == '=') {
-            tokens_.emplace_back(token_type::LessOrEq{});
-            input.get();
-            flag = false;
+void Lexer::ParseCharLexem(char lexem) {
+    if (Peek() == '=') {
+        switch (lexem) {
+            case '!':
+                ++pos_;
+                Emit(token_type::NotEq{});
+                return;
+            case '<':
+                ++pos_;
+                Emit(token_type::LessOrEq{});
+                return;
+            case '>':
+                ++pos_;
+                Emit(token_type::GreaterOrEq{});
+                return;
+            case '=':
+                ++pos_;
+                Emit(token_type::Eq{});
+                return;
+            default:
+                break;
         }
-    } else if (lexem == '>') {
-        if (input.peek() == '=') {
-            tokens_.emplace_back(token_type::GreaterOrEq{});
-            input.get();
-            flag = false;
+    }
+    Emit(token_type::Char{lexem});
+}
+
+void Lexer::ParseStringLexem(char quote) {
+    std::string str;
+    for (;;) {
+        // Участки без escape-последовательностей копируются из буфера целиком
+        const size_t start = pos_;
+        SkipWith([this, quote](const char* p, const char* end) {
+            return scanner_.find_quote_or_escape(p, end, quote);
+        });
+        str.append(source_.substr(start, pos_ - start));
+
+        const int c = Peek();
+        if (c == END) {
+            throw LexerError("Unterminated string literal"s);
         }
-    } else if (lexem == '=') {
-        if (input.peek() == '=') {
-            tokens_.emplace_back(token_type::Eq{});
-            input.get();
-            flag = false;
+        ++pos_;
+        if (c == quote) {
+            break;
         }
-    }
 
-    if (flag) {
-        tokens_.emplace_back(token_type::Char{lexem});
+        // Неизвестная escape-последовательность \x даёт символ x
+        switch (Peek()) {
+            case 't':
+                str += '\t';
+                break;
+            case 'n':
+                str += '\n';
+                break;
+            case 'r':
+                str += '\r';
+                break;
+            case '\\':
+                str += '\\';
+                break;
+            case '"':
+                str += '"';
+                break;
+            case '\'':
+                str += '\'';
+                break;
+            default:
+                continue;
+        }
+        ++pos_;
     }
+    Emit(token_type::String{std::move(str)});
 }
 
 }  // namespace parse
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <deque>
+#include <exception>
 #include <iosfwd>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 #include <iostream>
 #include <type_traits>
 
+#include "scan.h"
+#include "spsc_queue.h"
+#include "symbol.h"
+
 namespace parse {
 
 namespace token_type {
@@ -17,8 +26,8 @@ struct Number {  // Лексема «число»
     int value;   // число
 };
 
-struct Id {             // Лексема «идентификатор»
-    std::string value;  // Имя идентификатора
+struct Id {                 // Лексема «идентификатор»
+    runtime::Symbol value;  // Имя идентификатора, интернированное при разборе
 };
 
 struct Char {    // Лексема «символ»
@@ -34,6 +43,9 @@ struct Return {};   // Лексема «return»
 struct If {};       // Лексема «if»
 struct Else {};     // Лексема «else»
 struct Def {};      // Лексема «def»
+struct While {};    // Лексема «while»
+struct Break {};    // Лексема «break»
+struct Continue {};  // Лексема «continue»
 struct Newline {};  // Лексема «конец строки»
 struct Print {};    // Лексема «print»
 struct Indent {};  // Лексема «увеличение отступа», соответствует двум пробелам
@@ -54,7 +66,8 @@ struct False {};        // Лексема «False»
 using TokenBase
     = std::variant<token_type::Number, token_type::Id, token_type::Char, token_type::String,
                    token_type::Class, token_type::Return, token_type::If, token_type::Else,
-                   token_type::Def, token_type::Newline, token_type::Print, token_type::Indent,
+                   token_type::Def, token_type::While, token_type::Break, token_type::Continue,
+                   token_type::Newline, token_type::Print, token_type::Indent,
                    token_type::Dedent, token_type::And, token_type::Or, token_type::Not,
                    token_type::Eq, token_type::NotEq, token_type::LessOrEq, token_type::GreaterOrEq,
                    token_type::None, token_type::True, token_type::False, token_type::Eof>;
@@ -88,16 +101,52 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+// Способ получения токенов лексером
+enum class LexerMode {
+    // Весь входной поток разбивается на токены в конструкторе
+    Eager,
+    // Токены читаются из потока по мере вызова NextToken. В буфере хранятся лишь предыдущий,
+    // текущий и несколько уже прочитанных следующих токенов, поэтому память лексера
+    // не зависит от размера программы, а разбор идёт одновременно с чтением потока
+    Streaming,
+    // Текст разбирается на токены в отдельном потоке, который передаёт их в NextToken
+    // через ограниченную очередь SpscQueue. Когда очередь заполнена, поток лексера ждёт,
+    // пока разбор её освободит, поэтому память ограничена так же, как в потоковом режиме,
+    // а чтение текста, лексический и синтаксический разбор выполняются одновременно
+    Pipelined,
+};
+
 class Lexer {
 public:
-    explicit Lexer(std::istream& input);
+    // Читает текст программы из потока частями по CHUNK_SIZE байт
+    explicit Lexer(std::istream& input, LexerMode mode = LexerMode::Eager);
+    // Разбирает текст программы, расположенный в памяти целиком (например, в отображённом
+    // в память файле MappedFile). Текст должен существовать, пока используется лексер
+    explicit Lexer(std::string_view source, LexerMode mode = LexerMode::Eager);
+    // Останавливает поток лексера, если разбор закончился раньше текста
+    ~Lexer();
+
+    // Буфер текста и ссылки на токены привязаны к объекту лексера
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
+    // Размер части потока, читаемой за один раз
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    // Число токенов, которые поток лексера может разобрать впрок в режиме Pipelined
+    static constexpr size_t PIPELINE_CAPACITY = 4096;
 
     // Возвращает ссылку на текущий токен или token_type::Eof, если поток токенов закончился
     [[nodiscard]] const Token& CurrentToken() const;
 
-    // Возвращает следующий токен, либо token_type::Eof, если поток токенов закончился
+    // Возвращает следующий токен, либо token_type::Eof, если поток токенов закончился.
+    // Ссылка на предыдущий текущий токен остаётся действительной до следующего вызова
     const Token& NextToken();
 
+    // Возвращает число токенов в буфере лексера
+    [[nodiscard]] size_t GetBufferedTokenCount() const {
+        return tokens_.size();
+    }
+
     // Если текущий токен имеет тип T, метод возвращает ссылку на него.
     // В противном случае метод выбрасывает исключение LexerError
     template <typename T>
@@ -160,19 +209,75 @@ public:
         }
     }
 
-    bool ParseKeyLexem(const std::string& lexem);
-
-    void ParseIdLexem(const std::string& lexem);
-
-    void ParseDigitLexem(const std::string& lexem);
-
-    void ParseCharLexem(char lexem, std::istream& input);
-
 private:
-    std::vector<Token> tokens_;
-    int current_token_ = 0;
-    int max_token_;
-    int current_expect_ = 0;
+    // Значение Peek за концом текста
+    static constexpr int END = -1;
+
+    void Start();
+    // Разбирает очередную лексему и добавляет в буфер полученные из неё токены
+    void ScanLexeme();
+    // Разбирает текст, пока в буфере нет токена с номером index и не добавлен token_type::Eof
+    void Fill(size_t index);
+    void Emit(Token token);
+
+    // Исключение, которым прерывается поток лексера при уничтожении лексера
+    struct ProducerStopped {};
+    // Тело потока лексера в режиме Pipelined
+    void Produce();
+    // Передаёт токен в очередь, ожидая, пока в ней освободится место
+    void Send(Token token);
+    // Забирает токен из очереди, ожидая, пока поток лексера его разберёт
+    Token Receive();
+    void StopProducer();
+
+    // Дочитывает из потока очередную часть текста. Возвращает false и отмечает окончание текста,
+    // если читать больше нечего
+    bool Refill();
+    // Возвращает символ в позиции pos_ либо END
+    int Peek();
+    // Продвигает pos_ до символа, который вернула функция поиска scan(begin, end),
+    // дочитывая текст, если scan дошла до конца буфера
+    template <typename Scan>
+    void SkipWith(Scan scan);
+
+    // Лексемы берутся прямо из буфера текста, без посимвольного копирования
+    bool ParseKeyLexem(std::string_view lexem);
+    void ParseIdLexem(std::string_view lexem);
+    void ParseDigitLexem(std::string_view lexem);
+    void ParseCharLexem(char lexem);
+    void ParseStringLexem(char quote);
+
+    LexerMode mode_;
+    // Функции поиска границ лексем для набора команд процессора
+    const scan::Scanner& scanner_;
+    // Поток, из которого дочитывается текст, либо nullptr, если весь текст находится в source_
+    std::istream* input_ = nullptr;
+    // Прочитанная из потока и ещё не разобранная часть текста
+    std::string buffer_;
+    // Текст, доступный для разбора: buffer_ либо текст, переданный в конструктор
+    std::string_view source_;
+    size_t pos_ = 0;
+    // Попытка прочитать символ за концом текста
+    bool at_eof_ = false;
+
+    // В потоковом и конвейерном режимах буфер начинается с предыдущего токена
+    std::deque<Token> tokens_;
+    size_t current_token_ = 0;
+    int global_indent_ = 0;
+    int current_indent_ = 0;
+    bool is_new_line_ = true;
+    bool is_start_file_ = true;
+    // Последний добавленный токен требует токена Newline перед token_type::Eof
+    bool needs_newline_ = false;
+    bool finished_ = false;
+
+    // Очередь токенов и поток лексера существуют только в режиме Pipelined. Поток лексера
+    // владеет состоянием разбора текста, а tokens_ и current_token_ использует только читатель
+    std::unique_ptr<SpscQueue<Token>> queue_;
+    // Ошибка разбора в потоке лексера. Записывается до передачи завершающего token_type::Eof,
+    // поэтому читатель, получивший этот токен, видит её
+    std::exception_ptr producer_error_;
+    std::thread producer_;
 };
 
 }  // namespace parse
@@ -1,8 +1,16 @@
 #include "lexer.h"
+#include "mapped_file.h"
+#include "scan.h"
+#include "spsc_queue.h"
 #include "test_runner_p.h"
 
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 
 using namespace std;
 
@@ -40,6 +48,29 @@ void TestKeywords() {
     ASSERT_EQUAL(lexer.NextToken(), Token(token_type::False{}));
 }
 
+void TestLoopKeywords() {
+    istringstream input("while break continue While"s);
+    Lexer lexer(input);
+
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::While{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Break{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Continue{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"While"s}));
+}
+
+void TestKeywordLookalikes() {
+    // Слова, отличающиеся от ключевых одним символом или длиной, остаются идентификаторами
+    istringstream input("clas classes whilf i iF el_se continue_ Falsf nOne t True"s);
+    Lexer lexer(input);
+
+    for (const auto& id : {"clas"s, "classes"s, "whilf"s, "i"s, "iF"s, "el_se"s, "continue_"s,
+                           "Falsf"s, "nOne"s, "t"s}) {
+        ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{id}));
+        lexer.NextToken();
+    }
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::True{}));
+}
+
 void TestNumbers() {
     istringstream input("42 15 -53"s);
     Lexer lexer(input);
@@ -273,6 +304,224 @@ print str(p)
     ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
 }
 
+void TestStreamingLexer() {
+    const string program = R"(
+class Counter:
+  def add():
+    self.value = self.value + 1
+
+c = Counter()
+c.value = 0
+c.add()
+)"s;
+    istringstream eager_input(program);
+    istringstream streaming_input(program);
+    Lexer eager(eager_input);
+    Lexer streaming(streaming_input, LexerMode::Streaming);
+
+    for (;;) {
+        ASSERT_EQUAL(streaming.CurrentToken(), eager.CurrentToken());
+        if (eager.CurrentToken().Is<token_type::Eof>()) {
+            break;
+        }
+        const Token& previous = streaming.CurrentToken();
+        const Token copy = previous;
+        ASSERT_EQUAL(streaming.NextToken(), eager.NextToken());
+        ASSERT_EQUAL(previous, copy);
+    }
+    ASSERT_EQUAL(streaming.NextToken(), Token(token_type::Eof{}));
+
+    // Буфер не растёт вместе с программой
+    string large;
+    for (int i = 0; i < 10000; ++i) {
+        large += "x = x + 1\nif x:\n  print x\n"s;
+    }
+    istringstream large_input(large);
+    Lexer large_lexer(large_input, LexerMode::Streaming);
+    // Поток читается по мере получения токенов
+    ASSERT_EQUAL(large_input.tellg(), static_cast<streamoff>(Lexer::CHUNK_SIZE));
+    size_t max_buffered = 0;
+    size_t count = 0;
+    for (; !large_lexer.CurrentToken().Is<token_type::Eof>(); large_lexer.NextToken()) {
+        max_buffered = max(max_buffered, large_lexer.GetBufferedTokenCount());
+        ++count;
+    }
+    ASSERT_EQUAL(count, 150000U);
+    ASSERT(max_buffered <= 4U);
+}
+
+void TestSpscQueue() {
+    SpscQueue<int> queue(2);
+    ASSERT_EQUAL(queue.GetCapacity(), 2U);
+    int value = 1;
+    ASSERT(queue.TryPush(move(value)));
+    value = 2;
+    ASSERT(queue.TryPush(move(value)));
+    value = 3;
+    ASSERT(!queue.TryPush(move(value)));
+    ASSERT(queue.TryPop(value));
+    ASSERT_EQUAL(value, 1);
+
+    // Писатель, ждущий места в заполненной очереди, просыпается при закрытии очереди
+    ASSERT(queue.TryPush(3));
+    bool pushed = true;
+    thread writer([&] {
+        pushed = queue.Push(4);
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    queue.Close();
+    writer.join();
+    ASSERT(!pushed);
+
+    // Читатель, ждущий элемента, спит, а не занимает процессор
+    SpscQueue<int> stalled(4);
+    const clock_t cpu_start = clock();
+    thread slow_writer([&stalled] {
+        this_thread::sleep_for(chrono::milliseconds(200));
+        stalled.Push(42);
+    });
+    int received = 0;
+    stalled.Pop(received);
+    slow_writer.join();
+    ASSERT_EQUAL(received, 42);
+    ASSERT(clock() - cpu_start < CLOCKS_PER_SEC / 20);
+}
+
+void TestPipelinedLexer() {
+    // Поток лексера выдаёт те же токены, что и обычный лексер, сколько бы раз
+    // очередь ни заполнялась. Ссылка на предыдущий токен остаётся действительной
+    string program;
+    for (int i = 0; i < 5000; ++i) {
+        program += "if x_"s + to_string(i) + " >= 10:\n  print 'big', x\nelse:\n  x = x + 1\n"s;
+    }
+    istringstream eager_input(program);
+    istringstream pipelined_input(program);
+    Lexer eager(eager_input);
+    Lexer pipelined(pipelined_input, LexerMode::Pipelined);
+    size_t count = 0;
+    size_t max_buffered = 0;
+    for (;;) {
+        ASSERT_EQUAL(pipelined.CurrentToken(), eager.CurrentToken());
+        if (eager.CurrentToken().Is<token_type::Eof>()) {
+            break;
+        }
+        const Token& previous = pipelined.CurrentToken();
+        const Token copy = previous;
+        ASSERT_EQUAL(pipelined.NextToken(), eager.NextToken());
+        ASSERT_EQUAL(previous, copy);
+        max_buffered = max(max_buffered, pipelined.GetBufferedTokenCount());
+        ++count;
+    }
+    ASSERT(count > 10 * Lexer::PIPELINE_CAPACITY);
+    ASSERT(max_buffered <= 2U);
+    ASSERT_EQUAL(pipelined.NextToken(), Token(token_type::Eof{}));
+
+    // Ошибка разбора выбрасывается из NextToken после всех токенов, предшествующих ей
+    {
+        Lexer lexer("x = 1\ny = 'unterminated"sv, LexerMode::Pipelined);
+        ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"x"s}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{1}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"y"s}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+        ASSERT_THROWS(lexer.NextToken(), LexerError);
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+    }
+    ASSERT_THROWS(Lexer("'unterminated"sv, LexerMode::Pipelined), LexerError);
+
+    // Лексер, уничтоженный до конца текста, останавливает поток, ждущий места в очереди
+    for (int i = 0; i < 10; ++i) {
+        istringstream abandoned_input(program);
+        Lexer lexer(abandoned_input, LexerMode::Pipelined);
+        ASSERT(lexer.CurrentToken().Is<token_type::If>());
+    }
+}
+
+void TestBufferLexer() {
+    // Лексемы, пересекающие границы частей потока, разбираются так же, как из буфера
+    string program = "class Greeter:\n  def greet(name):\n    # comment\n    return 'Hello, \\'' + name\n"s;
+    while (program.size() < 3 * Lexer::CHUNK_SIZE) {
+        program += "value_"s + to_string(program.size()) + " = \"tab\\there\" + 'x' <= 12345\n"s;
+    }
+    istringstream input(program);
+    Lexer from_stream(input);
+    Lexer from_buffer(string_view{program});
+    size_t count = 0;
+    for (;;) {
+        ASSERT_EQUAL(from_buffer.CurrentToken(), from_stream.CurrentToken());
+        if (from_buffer.CurrentToken().Is<token_type::Eof>()) {
+            break;
+        }
+        from_buffer.NextToken();
+        from_stream.NextToken();
+        ++count;
+    }
+    ASSERT(count > 30000U);
+
+    // Строки и идентификаторы вырезаются из буфера, escape-последовательности заменяются
+    Lexer lexer("s = 'a\\tb\\q' + \"\\\"\""sv);
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"s"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{"a\tbq"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'+'}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{"\""s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+
+    ASSERT_THROWS(Lexer("s = 'unterminated"sv), LexerError);
+    ASSERT_THROWS(Lexer("x = 99999999999"sv), LexerError);
+}
+
+void TestMappedFile() {
+    const string path = (filesystem::temp_directory_path() / "mython_mapped_file_test.my").string();
+    {
+        ofstream file(path, ios::binary);
+        file << "x = 'mapped'\nprint x\n"s;
+    }
+    {
+        const MappedFile file(path);
+        ASSERT_EQUAL(file.GetContents(), "x = 'mapped'\nprint x\n"sv);
+        Lexer lexer(file.GetContents());
+        ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"x"s}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{"mapped"s}));
+    }
+    filesystem::remove(path);
+    ASSERT_THROWS(MappedFile{path}, runtime_error);
+}
+
+void TestVectorScanners() {
+    // Граница лексемы стоит в каждой позиции относительно блоков по 16 и 32 символа,
+    // а символы вне ASCII не считаются частью идентификатора
+    string text(100, ' ');
+    text += "Name_09zZ"s + string(70, 'a') + "\xff@[`{/:"s + string(80, '#') + "'\\"s + "\n"s;
+    text += string(40, 'q') + '"' + string(50, ' ');
+    text[150] = '\xff';
+
+    const scan::Scanner& scalar = *scan::GetScanner(scan::Level::Scalar);
+    for (const auto level : {scan::Level::Sse2, scan::Level::Avx2}) {
+        const scan::Scanner* vector = scan::GetScanner(level);
+        if (vector == nullptr) {
+            continue;
+        }
+        const char* const end = text.data() + text.size();
+        for (const char* p = text.data(); p != end; ++p) {
+            ASSERT(vector->skip_spaces(p, end) == scalar.skip_spaces(p, end));
+            ASSERT(vector->skip_identifier(p, end) == scalar.skip_identifier(p, end));
+            ASSERT(vector->find_line_end(p, end) == scalar.find_line_end(p, end));
+            for (const char quote : {'"', '\''}) {
+                ASSERT(vector->find_quote_or_escape(p, end, quote)
+                       == scalar.find_quote_or_escape(p, end, quote));
+            }
+        }
+    }
+    // Лексер использует самый широкий из доступных наборов команд
+    if (scan::GetScanner(scan::Level::Sse2) != nullptr) {
+        ASSERT(scan::GetScanner().level != scan::Level::Scalar);
+    }
+}
+
 void TestExpect() {
     istringstream is("bugaga"s);
     Lexer lex(is);
@@ -356,6 +605,8 @@ abc#
 void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestSimpleAssignment);
     RUN_TEST(tr, parse::TestKeywords);
+    RUN_TEST(tr, parse::TestLoopKeywords);
+    RUN_TEST(tr, parse::TestKeywordLookalikes);
     RUN_TEST(tr, parse::TestNumbers);
     RUN_TEST(tr, parse::TestIds);
     RUN_TEST(tr, parse::TestStrings);
@@ -367,6 +618,12 @@ void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestMythonProgram);
     RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
     RUN_TEST(tr, parse::TestCommentsAreIgnored);
+    RUN_TEST(tr, parse::TestStreamingLexer);
+    RUN_TEST(tr, parse::TestSpscQueue);
+    RUN_TEST(tr, parse::TestPipelinedLexer);
+    RUN_TEST(tr, parse::TestBufferLexer);
+    RUN_TEST(tr, parse::TestMappedFile);
+    RUN_TEST(tr, parse::TestVectorScanners);
 }
 
 }  // namespace parse
\ No newline at end of file
@@ -1,10 +1,17 @@
+#include "bytecode.h"
+#include "gc.h"
 #include "lexer.h"
+#include "mapped_file.h"
 #include "parse.h"
 #include "runtime.h"
 #include "statement.h"
 #include "test_runner_p.h"
+#include "vm.h"
 
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
 
 using namespace std;
 
@@ -18,19 +25,48 @@ void RunUnitTests(TestRunner& tr);
 namespace runtime {
 void RunObjectHolderTests(TestRunner& tr);
 void RunObjectsTests(TestRunner& tr);
+void RunVmTests(TestRunner& tr);
+void RunGcTests(TestRunner& tr);
 }  // namespace runtime
 
 void TestParseProgram(TestRunner& tr);
 
 namespace {
 
-void RunMythonProgram(istream& input, ostream& output) {
-    parse::Lexer lexer(input);
-    auto program = ParseProgram(lexer);
+// Способ исполнения программы
+enum class ExecutionMode {
+    TreeWalk,  // обход AST
+    Bytecode,  // компиляция в байт-код и исполнение на runtime::VM
+};
+
+void RunMythonProgram(runtime::Executable& program, ostream& output, ExecutionMode mode,
+                      runtime::MemoryMode memory) {
+    // Куча разрушается после таблицы символов, ссылающейся на её объекты
+    runtime::GcHeap heap;
+    std::optional<runtime::GcHeap::Scope> heap_scope;
+    if (memory == runtime::MemoryMode::TracingGc) {
+        heap_scope.emplace(heap);
+    }
 
     runtime::SimpleContext context{output};
     runtime::Closure closure;
-    program->Execute(closure, context);
+    if (mode == ExecutionMode::Bytecode) {
+        bytecode::Program code = bytecode::Compile(program);
+        runtime::VM(code).Run(closure, context);
+    } else {
+        program.Execute(closure, context);
+    }
+}
+
+void RunMythonProgram(istream& input, ostream& output,
+                      ExecutionMode mode = ExecutionMode::TreeWalk,
+                      runtime::MemoryMode memory = runtime::DEFAULT_MEMORY_MODE) {
+    // Программа читается по мере разбора, токены всей программы не хранятся в памяти.
+    // Если есть свободное ядро, чтение и лексический разбор идут в отдельном потоке
+    const auto lexer_mode = thread::hardware_concurrency() > 1 ? parse::LexerMode::Pipelined
+                                                                 : parse::LexerMode::Streaming;
+    parse::Lexer lexer(input, lexer_mode);
+    RunMythonProgram(*ParseProgram(lexer), output, mode, memory);
 }
 
 void TestSimplePrints() {
@@ -118,6 +154,8 @@ void TestAll() {
     runtime::RunObjectsTests(tr);
     ast::RunUnitTests(tr);
     TestParseProgram(tr);
+    runtime::RunVmTests(tr);
+    runtime::RunGcTests(tr);
 
     RUN_TEST(tr, TestSimplePrints);
     RUN_TEST(tr, TestAssignments);
@@ -127,11 +165,36 @@ void TestAll() {
 
 }  // namespace
 
-int main() {
+// Ключ --vm включает исполнение программы на виртуальной машине вместо обхода AST.
+// Ключи --gc и --refcount выбирают способ управления памятью вместо выбранного при сборке.
+// Программа читается из файла, путь к которому указан в аргументах, либо из стандартного ввода
+int main(int argc, char* argv[]) {
+    ExecutionMode mode = ExecutionMode::TreeWalk;
+    runtime::MemoryMode memory = runtime::DEFAULT_MEMORY_MODE;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--vm"sv) {
+            mode = ExecutionMode::Bytecode;
+        } else if (argv[i] == "--gc"sv) {
+            memory = runtime::MemoryMode::TracingGc;
+        } else if (argv[i] == "--refcount"sv) {
+            memory = runtime::MemoryMode::RefCounting;
+        } else {
+            path = argv[i];
+        }
+    }
+
     try {
         TestAll();
 
-        RunMythonProgram(cin, cout);
+        if (path != nullptr) {
+            // Файл отображается в память, и его части разбираются параллельно
+            // без промежуточного буфера
+            const parse::MappedFile file(path);
+            RunMythonProgram(*ParseProgramParallel(file.GetContents()), cout, mode, memory);
+        } else {
+            RunMythonProgram(cin, cout, mode, memory);
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
 		return 1;
@@ -0,0 +1,71 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MYTHON_HAS_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#define MYTHON_HAS_MMAP 0
+#endif
+
+using namespace std;
+
+namespace parse {
+
+#if MYTHON_HAS_MMAP
+
+MappedFile::MappedFile(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Cannot open file "s + path);
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw runtime_error("Cannot read file "s + path);
+    }
+
+    size_ = static_cast<size_t>(info.st_size);
+    // Пустой файл отобразить нельзя, он соответствует пустому тексту
+    if (size_ != 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Cannot map file "s + path);
+        }
+        // Текст читается лексером последовательно
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const string& path) {
+    ifstream input(path, ios::binary);
+    if (!input) {
+        throw runtime_error("Cannot open file "s + path);
+    }
+    fallback_.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#endif
+
+}  // namespace parse
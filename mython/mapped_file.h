@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace parse {
+
+/*
+ * Файл, отображённый в память только для чтения. Позволяет лексеру разбирать текст программы
+ * прямо из страниц файла, без копирования в буфер потока.
+ * На системах без mmap содержимое файла читается в память целиком
+ */
+class MappedFile {
+public:
+    // Отображает файл path в память. Если файл не удаётся открыть, выбрасывает std::runtime_error
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Содержимое файла, действительное, пока существует объект
+    [[nodiscard]] std::string_view GetContents() const {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    // Содержимое файла, если оно прочитано, а не отображено в память
+    std::string fallback_;
+};
+
+}  // namespace parse
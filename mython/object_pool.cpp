@@ -0,0 +1,193 @@
+#include "object_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <utility>
+#include <new>
+
+using namespace std;
+
+namespace runtime::object_pool {
+
+namespace {
+
+constexpr size_t SIZE_CLASS_COUNT = MAX_POOLED_SIZE / GRANULARITY;
+// Размер участка памяти, который нарезается на блоки при пополнении пула
+constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+static_assert(GRANULARITY >= alignof(max_align_t));
+
+// Свободный блок хранит указатель на следующий свободный блок своего класса размера
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+constexpr size_t SizeClassOf(size_t size) {
+    return (max(size, size_t{1}) + GRANULARITY - 1) / GRANULARITY - 1;
+}
+
+constexpr size_t BlockSizeOf(size_t size_class) {
+    return (size_class + 1) * GRANULARITY;
+}
+
+using FreeLists = array<FreeBlock*, SIZE_CLASS_COUNT>;
+
+// Свободные блоки завершившихся потоков
+class Reserve {
+public:
+    static Reserve& Instance() {
+        // Резерв не разрушается, чтобы объекты, удаляемые при завершении программы, могли вернуть блоки
+        static Reserve* reserve = new Reserve();
+        return *reserve;
+    }
+
+    void Donate(FreeLists& lists) {
+        lock_guard guard(mutex_);
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+            while (FreeBlock* block = lists[i]) {
+                lists[i] = block->next;
+                block->next = lists_[i];
+                lists_[i] = block;
+            }
+        }
+    }
+
+    void Donate(size_t size_class, FreeBlock* block) {
+        lock_guard guard(mutex_);
+        block->next = lists_[size_class];
+        lists_[size_class] = block;
+    }
+
+    // Забирает все свободные блоки класса size_class
+    FreeBlock* Take(size_t size_class) {
+        lock_guard guard(mutex_);
+        return exchange(lists_[size_class], nullptr);
+    }
+
+    // Забирает один свободный блок класса size_class либо возвращает nullptr
+    FreeBlock* TakeOne(size_t size_class) {
+        lock_guard guard(mutex_);
+        FreeBlock* block = lists_[size_class];
+        if (block != nullptr) {
+            lists_[size_class] = block->next;
+        }
+        return block;
+    }
+
+private:
+    mutex mutex_;
+    FreeLists lists_{};
+};
+
+class ThreadPool {
+public:
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    void* Allocate(size_t size) {
+        if (size > MAX_POOLED_SIZE) {
+            ++stats_.misses;
+            return ::operator new(size);
+        }
+
+        const size_t size_class = SizeClassOf(size);
+        FreeBlock*& head = free_lists_[size_class];
+        if (head != nullptr) {
+            ++stats_.hits;
+        } else {
+            ++stats_.misses;
+            Refill(size_class);
+        }
+
+        FreeBlock* block = head;
+        head = block->next;
+        stats_.bytes += BlockSizeOf(size_class);
+        stats_.peak_bytes = max(stats_.peak_bytes, stats_.bytes);
+        return block;
+    }
+
+    void Free(void* object, size_t size) noexcept {
+        if (size > MAX_POOLED_SIZE) {
+            ::operator delete(object);
+            return;
+        }
+
+        const size_t size_class = SizeClassOf(size);
+        auto* block = static_cast<FreeBlock*>(object);
+        block->next = free_lists_[size_class];
+        free_lists_[size_class] = block;
+        stats_.bytes -= min(stats_.bytes, BlockSizeOf(size_class));
+    }
+
+    PoolStats& GetStats() {
+        return stats_;
+    }
+
+private:
+    // Пополняет список свободных блоков из резерва, а если он пуст - новым участком памяти
+    void Refill(size_t size_class) {
+        FreeBlock*& head = free_lists_[size_class];
+        head = Reserve::Instance().Take(size_class);
+        if (head != nullptr) {
+            return;
+        }
+
+        const size_t block_size = BlockSizeOf(size_class);
+        auto* chunk = static_cast<byte*>(::operator new(CHUNK_SIZE));
+        for (size_t offset = CHUNK_SIZE / block_size * block_size; offset != 0; offset -= block_size) {
+            auto* block = reinterpret_cast<FreeBlock*>(chunk + offset - block_size);
+            block->next = head;
+            head = block;
+        }
+    }
+
+    FreeLists free_lists_{};
+    PoolStats stats_;
+};
+
+thread_local ThreadPool thread_pool;
+// Объекты могут удаляться деструкторами других thread_local и статических переменных уже после
+// разрушения пула потока. Тогда блоки размещаются и освобождаются через общий резерв
+thread_local bool thread_pool_destroyed = false;
+thread_local PoolStats orphan_stats;
+
+ThreadPool::~ThreadPool() {
+    Reserve::Instance().Donate(free_lists_);
+    thread_pool_destroyed = true;
+}
+
+}  // namespace
+
+void* Allocate(size_t size) {
+    if (!thread_pool_destroyed) {
+        return thread_pool.Allocate(size);
+    }
+    if (size > MAX_POOLED_SIZE) {
+        return ::operator new(size);
+    }
+    const size_t size_class = SizeClassOf(size);
+    if (FreeBlock* block = Reserve::Instance().TakeOne(size_class)) {
+        return block;
+    }
+    return ::operator new(BlockSizeOf(size_class));
+}
+
+void Free(void* object, size_t size) noexcept {
+    if (!thread_pool_destroyed) {
+        thread_pool.Free(object, size);
+    } else if (size > MAX_POOLED_SIZE) {
+        ::operator delete(object);
+    } else {
+        Reserve::Instance().Donate(SizeClassOf(size), static_cast<FreeBlock*>(object));
+    }
+}
+
+PoolStats& GetStats() {
+    return thread_pool_destroyed ? orphan_stats : thread_pool.GetStats();
+}
+
+}  // namespace runtime::object_pool
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+namespace runtime {
+
+// Статистика пулов объектов, собираемая отдельно для каждого потока
+struct PoolStats {
+    // Размещения, обслуженные из списка свободных блоков потока
+    size_t hits = 0;
+    // Размещения, потребовавшие новой памяти, в том числе объекты больше MAX_POOLED_SIZE
+    size_t misses = 0;
+    // Байт в блоках, занятых объектами. Объект, удалённый в другом потоке,
+    // учитывается в статистике удалившего его потока
+    size_t bytes = 0;
+    // Наибольшее значение bytes
+    size_t peak_bytes = 0;
+};
+
+/*
+ * Пулы памяти для объектов Mython, размещаемых в куче.
+ * Объекты не больше MAX_POOLED_SIZE байт округляются до класса размера, кратного GRANULARITY,
+ * и размещаются в блоках из пула этого класса. У каждого потока свои списки свободных блоков,
+ * поэтому размещение и удаление не требуют синхронизации. Память пулов не возвращается системе:
+ * при завершении потока его свободные блоки передаются в общий резерв, из которого
+ * пополняются пулы других потоков
+ */
+namespace object_pool {
+
+inline constexpr size_t GRANULARITY = 16;
+inline constexpr size_t MAX_POOLED_SIZE = 256;
+
+// Выделяет память для объекта размера size
+[[nodiscard]] void* Allocate(size_t size);
+
+// Освобождает память объекта размера size, выделенную функцией Allocate
+void Free(void* object, size_t size) noexcept;
+
+// Возвращает статистику пулов текущего потока
+[[nodiscard]] PoolStats& GetStats();
+
+}  // namespace object_pool
+
+}  // namespace runtime
@@ -1,8 +1,20 @@
 #include "parse.h"
 
 #include "lexer.h"
+#include "scan.h"
 #include "statement.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
 using namespace std;
 
 namespace TokenType = parse::token_type;
@@ -17,15 +29,132 @@ bool operator!=(const parse::Token& token, char c) {
     return !(token == c);
 }
 
+// Приоритеты операторов выражений в порядке возрастания
+constexpr int LOWEST_PRECEDENCE = 0;
+constexpr int OR_PRECEDENCE = 1;
+constexpr int AND_PRECEDENCE = 2;
+constexpr int NOT_PRECEDENCE = 3;
+constexpr int COMPARISON_PRECEDENCE = 4;
+constexpr int ADD_PRECEDENCE = 5;
+constexpr int MULT_PRECEDENCE = 6;
+// Приоритет операндов: констант, переменных, вызовов, выражений в скобках и унарного минуса
+constexpr int PRIMARY_PRECEDENCE = 7;
+
+using Operand = unique_ptr<ast::Statement>;
+
+struct InfixOperator {
+    int precedence = LOWEST_PRECEDENCE;
+    // Ассоциативные операторы вычисляются слева направо, неассоциативные не повторяются подряд
+    bool associative = true;
+    Operand (*make)(Operand lhs, Operand rhs) = nullptr;
+};
+
+template <typename Node>
+Operand MakeBinary(Operand lhs, Operand rhs) {
+    return make_unique<Node>(std::move(lhs), std::move(rhs));
+}
+
+template <bool (*Cmp)(const runtime::ObjectHolder&, const runtime::ObjectHolder&,
+                      runtime::Context&)>
+Operand MakeComparison(Operand lhs, Operand rhs) {
+    return make_unique<ast::Comparison>(Cmp, std::move(lhs), std::move(rhs));
+}
+
+constexpr InfixOperator OR{OR_PRECEDENCE, true, MakeBinary<ast::Or>};
+constexpr InfixOperator AND{AND_PRECEDENCE, true, MakeBinary<ast::And>};
+constexpr InfixOperator ADD{ADD_PRECEDENCE, true, MakeBinary<ast::Add>};
+constexpr InfixOperator SUB{ADD_PRECEDENCE, true, MakeBinary<ast::Sub>};
+constexpr InfixOperator MULT{MULT_PRECEDENCE, true, MakeBinary<ast::Mult>};
+constexpr InfixOperator DIV{MULT_PRECEDENCE, true, MakeBinary<ast::Div>};
+constexpr InfixOperator LESS{COMPARISON_PRECEDENCE, false, MakeComparison<runtime::Less>};
+constexpr InfixOperator GREATER{COMPARISON_PRECEDENCE, false, MakeComparison<runtime::Greater>};
+constexpr InfixOperator EQUAL{COMPARISON_PRECEDENCE, false, MakeComparison<runtime::Equal>};
+constexpr InfixOperator NOT_EQUAL{COMPARISON_PRECEDENCE, false,
+                                  MakeComparison<runtime::NotEqual>};
+constexpr InfixOperator LESS_OR_EQUAL{COMPARISON_PRECEDENCE, false,
+                                      MakeComparison<runtime::LessOrEqual>};
+constexpr InfixOperator GREATER_OR_EQUAL{COMPARISON_PRECEDENCE, false,
+                                         MakeComparison<runtime::GreaterOrEqual>};
+
+// Номер типа токена T в parse::TokenBase
+template <typename T, typename... Types>
+constexpr size_t TokenIndex(std::variant<Types...>* /*tag*/) {
+    constexpr bool matches[] = {std::is_same_v<T, Types>...};
+    size_t index = 0;
+    while (!matches[index]) {
+        ++index;
+    }
+    return index;
+}
+
+template <typename T>
+constexpr size_t TOKEN_INDEX = TokenIndex<T>(static_cast<parse::TokenBase*>(nullptr));
+
+// Операторы, записываемые отдельным типом токена, по номеру типа токена
+constexpr auto TOKEN_OPERATORS = [] {
+    std::array<const InfixOperator*, std::variant_size_v<parse::TokenBase>> operators{};
+    operators[TOKEN_INDEX<TokenType::Or>] = &OR;
+    operators[TOKEN_INDEX<TokenType::And>] = &AND;
+    operators[TOKEN_INDEX<TokenType::Eq>] = &EQUAL;
+    operators[TOKEN_INDEX<TokenType::NotEq>] = &NOT_EQUAL;
+    operators[TOKEN_INDEX<TokenType::LessOrEq>] = &LESS_OR_EQUAL;
+    operators[TOKEN_INDEX<TokenType::GreaterOrEq>] = &GREATER_OR_EQUAL;
+    return operators;
+}();
+
+// Односимвольные операторы по коду символа
+constexpr auto CHAR_OPERATORS = [] {
+    std::array<const InfixOperator*, 256> operators{};
+    operators['+'] = &ADD;
+    operators['-'] = &SUB;
+    operators['*'] = &MULT;
+    operators['/'] = &DIV;
+    operators['<'] = &LESS;
+    operators['>'] = &GREATER;
+    return operators;
+}();
+
+// Возвращает инфиксный оператор, которому соответствует токен, либо nullptr
+const InfixOperator* FindInfixOperator(const parse::Token& token) {
+    if (const auto* c = token.TryAs<TokenType::Char>()) {
+        return CHAR_OPERATORS[static_cast<unsigned char>(c->value)];
+    }
+    return TOKEN_OPERATORS[token.index()];
+}
+
+// Класс, объявленный в части программы при параллельном разборе. Объект класса создаётся
+// до разбора частей, чтобы на него могли ссылаться следующие части программы
+struct DeclaredClass {
+    runtime::ObjectHolder cls;
+    // Номер части программы, в которой класс объявлен впервые
+    size_t chunk = 0;
+};
+
+using ClassRegistry = std::unordered_map<runtime::Symbol, DeclaredClass>;
+
 class Parser {
 public:
     explicit Parser(parse::Lexer& lexer)
         : lexer_(lexer) {
     }
 
+    // Разбирает часть программы с номером chunk. Классы из registry, объявленные
+    // в предыдущих частях, считаются объявленными до начала этой части
+    Parser(parse::Lexer& lexer, const ClassRegistry& registry, size_t chunk)
+        : lexer_(lexer)
+        , registry_(&registry)
+        , chunk_(chunk) {
+    }
+
+    // Классы, таблицы методов которых нужно построить после разбора всех частей программы,
+    // в порядке объявления
+    [[nodiscard]] const vector<runtime::Class*>& GetDeferredClasses() const {
+        return deferred_classes_;
+    }
+
     // Program -> eps
     //          | Statement \n Program
-    unique_ptr<ast::Statement> ParseProgram() {
+    unique_ptr<ast::Compound> ParseProgram() {
         auto result = make_unique<ast::Compound>();
         while (!lexer_.CurrentToken().Is<TokenType::Eof>()) {
             result->AddStatement(ParseStatement());
@@ -76,8 +205,31 @@ private:
             lexer_.ExpectNext<TokenType::Char>(':');
             lexer_.NextToken();
 
+            // Слот 0 - self, за ним формальные параметры, затем локальные переменные
+            // в порядке первого присваивания
+            Scope scope;
+            scope.slots.emplace("self"s, 0);
+            for (runtime::Symbol param : m.formal_params) {
+                scope.slots.emplace(param, scope.slots.size());
+            }
+            Scope* outer_scope = std::exchange(locals_, &scope);
+            // break и continue в теле метода не относятся к циклам, внутри которых объявлен класс
+            const size_t outer_loop_depth = std::exchange(loop_depth_, 0);
+
             m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            // Имя, присвоенное где-либо в теле метода, - локальная переменная во всём теле:
+            // в цикле чтение может стоять в тексте раньше присваивания. Связывание выполняется
+            // до свёртки констант, пока узлы из unresolved_reads принадлежат дереву
+            for (ast::VariableValue* read : scope.unresolved_reads) {
+                if (auto it = scope.slots.find(read->GetRootName()); it != scope.slots.end()) {
+                    read->BindSlot(it->second);
+                }
+            }
+            ast::Optimize(m.body);
+            m.frame_size = scope.slots.size();
 
+            locals_ = outer_scope;
+            loop_depth_ = outer_loop_depth;
             result.push_back(std::move(m));
         }
         return result;
@@ -86,21 +238,20 @@ private:
     // ClassDefinition -> Id ['(' Id ')'] : new_line indent MethodList dedent
     unique_ptr<ast::Statement> ParseClassDefinition()  // NOLINT
     {
-        string class_name = lexer_.Expect<TokenType::Id>().value;
+        string class_name = lexer_.Expect<TokenType::Id>().value.GetName();
 
         lexer_.NextToken();
 
         const runtime::Class* base_class = nullptr;
         if (lexer_.CurrentToken() == '(') {
-            auto name = lexer_.ExpectNext<TokenType::Id>().value;
+            runtime::Symbol name = lexer_.ExpectNext<TokenType::Id>().value;
             lexer_.ExpectNext<TokenType::Char>(')');
             lexer_.NextToken();
 
-            auto it = declared_classes_.find(name);
-            if (it == declared_classes_.end()) {
-                throw ParseError("Base class "s + name + " not found for class "s + class_name);
+            base_class = FindClass(name);
+            if (base_class == nullptr) {
+                throw ParseError("Base class "s + name.GetName() + " not found for class "s + class_name);
             }
-            base_class = static_cast<const runtime::Class*>(it->second.Get());  // NOLINT
         }
 
         lexer_.Expect<TokenType::Char>(':');
@@ -112,6 +263,10 @@ private:
         lexer_.Expect<TokenType::Dedent>();
         lexer_.NextToken();
 
+        if (registry_ != nullptr) {
+            return DeclareDeferredClass(class_name, std::move(methods), base_class);
+        }
+
         auto [it, inserted] = declared_classes_.insert({
             class_name,
             runtime::ObjectHolder::Own(runtime::Class(class_name, std::move(methods), base_class)),
@@ -124,8 +279,49 @@ private:
         return make_unique<ast::ClassDefinition>(it->second);
     }
 
-    vector<string> ParseDottedIds() {
-        vector<string> result(1, lexer_.Expect<TokenType::Id>().value);
+    // Родитель класса может находиться в другой части программы и разбираться одновременно
+    // с этой, поэтому таблица методов класса строится после разбора всех частей
+    unique_ptr<ast::Statement> DeclareDeferredClass(const string& class_name,
+                                                    vector<runtime::Method> methods,
+                                                    const runtime::Class* base_class) {
+        const runtime::Symbol name = class_name;
+        const auto it = registry_->find(name);
+        if (declared_classes_.count(name) != 0
+            || (it != registry_->end() && it->second.chunk < chunk_)) {
+            throw ParseError("Class "s + class_name + " already exists"s);
+        }
+
+        runtime::ObjectHolder holder;
+        if (it != registry_->end() && it->second.chunk == chunk_) {
+            holder = it->second.cls;
+        } else {
+            holder = runtime::ObjectHolder::Own(runtime::Class(class_name, {}, nullptr));
+        }
+        auto* cls = holder.TryAs<runtime::Class>();
+        cls->methods_ = std::move(methods);
+        cls->parent_ = base_class;
+        deferred_classes_.push_back(cls);
+
+        declared_classes_.emplace(name, holder);
+        return make_unique<ast::ClassDefinition>(std::move(holder));
+    }
+
+    // Возвращает класс name, объявленный до текущего места программы, либо nullptr
+    [[nodiscard]] const runtime::Class* FindClass(runtime::Symbol name) const {
+        if (auto it = declared_classes_.find(name); it != declared_classes_.end()) {
+            return static_cast<const runtime::Class*>(it->second.Get());  // NOLINT
+        }
+        if (registry_ != nullptr) {
+            const auto it = registry_->find(name);
+            if (it != registry_->end() && it->second.chunk < chunk_) {
+                return static_cast<const runtime::Class*>(it->second.cls.Get());  // NOLINT
+            }
+        }
+        return nullptr;
+    }
+
+    vector<runtime::Symbol> ParseDottedIds() {
+        vector<runtime::Symbol> result(1, lexer_.Expect<TokenType::Id>().value);
 
         while (lexer_.NextToken() == '.') {
             result.push_back(lexer_.ExpectNext<TokenType::Id>().value);
@@ -139,24 +335,33 @@ private:
     unique_ptr<ast::Statement> ParseAssignmentOrCall() {
         lexer_.Expect<TokenType::Id>();
 
-        vector<string> id_list = ParseDottedIds();
-        string last_name = id_list.back();
+        vector<runtime::Symbol> id_list = ParseDottedIds();
+        runtime::Symbol last_name = id_list.back();
         id_list.pop_back();
 
         if (lexer_.CurrentToken() == '=') {
             lexer_.NextToken();
 
             if (id_list.empty()) {
-                return make_unique<ast::Assignment>(std::move(last_name), ParseTest());
+                auto rv = ParseTest();
+                if (locals_ != nullptr) {
+                    // Слот выделяется после разбора правой части: в ней переменная ещё не определена
+                    const size_t slot
+                        = locals_->slots.emplace(last_name, locals_->slots.size()).first->second;
+                    return make_unique<ast::Assignment>(last_name, slot, std::move(rv));
+                }
+                return make_unique<ast::Assignment>(last_name, std::move(rv));
             }
-            return make_unique<ast::FieldAssignment>(ast::VariableValue{std::move(id_list)},
-                                                     std::move(last_name), ParseTest());
+            auto result = make_unique<ast::FieldAssignment>(
+                ast::VariableValue{std::move(id_list)}, last_name, ParseTest());
+            ResolveRead(result->GetObject());
+            return result;
         }
         lexer_.Expect<TokenType::Char>('(');
         lexer_.NextToken();
 
         if (id_list.empty()) {
-            throw ParseError("Mython doesn't support functions, only methods: "s + last_name);
+            throw ParseError("Mython doesn't support functions, only methods: "s + last_name.GetName());
         }
 
         vector<unique_ptr<ast::Statement>> args;
@@ -166,42 +371,8 @@ private:
         lexer_.Expect<TokenType::Char>(')');
         lexer_.NextToken();
 
-        return make_unique<ast::MethodCall>(make_unique<ast::VariableValue>(std::move(id_list)),
-                                            std::move(last_name), std::move(args));
-    }
-
-    // Expr -> Adder ['+'/'-' Adder]*
-    unique_ptr<ast::Statement> ParseExpression()  // NOLINT
-    {
-        unique_ptr<ast::Statement> result = ParseAdder();
-        while (lexer_.CurrentToken() == '+' || lexer_.CurrentToken() == '-') {
-            char op = lexer_.CurrentToken().As<TokenType::Char>().value;
-            lexer_.NextToken();
-
-            if (op == '+') {
-                result = make_unique<ast::Add>(std::move(result), ParseAdder());
-            } else {
-                result = make_unique<ast::Sub>(std::move(result), ParseAdder());
-            }
-        }
-        return result;
-    }
-
-    // Adder -> Mult ['*'/'/' Mult]*
-    unique_ptr<ast::Statement> ParseAdder()  // NOLINT
-    {
-        unique_ptr<ast::Statement> result = ParseMult();
-        while (lexer_.CurrentToken() == '*' || lexer_.CurrentToken() == '/') {
-            char op = lexer_.CurrentToken().As<TokenType::Char>().value;
-            lexer_.NextToken();
-
-            if (op == '*') {
-                result = make_unique<ast::Mult>(std::move(result), ParseMult());
-            } else {
-                result = make_unique<ast::Div>(std::move(result), ParseMult());
-            }
-        }
-        return result;
+        return make_unique<ast::MethodCall>(MakeVariableValue(std::move(id_list)), last_name,
+                                            std::move(args));
     }
 
     // Mult -> '(' Expr ')'
@@ -217,14 +388,19 @@ private:
     {
         if (lexer_.CurrentToken() == '(') {
             lexer_.NextToken();
-            auto result = ParseTest();
+            auto result = ParseTest();  // NOLINT
             lexer_.Expect<TokenType::Char>(')');
             lexer_.NextToken();
             return result;
         }
         if (lexer_.CurrentToken() == '-') {
             lexer_.NextToken();
-            return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
+            auto operand = ParseMult();
+            // Отрицательное число сразу становится константой
+            if (const auto* num = dynamic_cast<const ast::NumericConst*>(operand.get())) {
+                return make_unique<ast::NumericConst>(-num->GetValue().GetValue());
+            }
+            return make_unique<ast::Mult>(std::move(operand), make_unique<ast::NumericConst>(-1));
         }
         if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
             int result = num->value;
@@ -253,7 +429,7 @@ private:
     }
 
     std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
-        vector<string> names = ParseDottedIds();
+        vector<runtime::Symbol> names = ParseDottedIds();
 
         if (lexer_.CurrentToken() == '(') {
             // various calls
@@ -268,23 +444,40 @@ private:
             names.pop_back();
 
             if (!names.empty()) {
-                return make_unique<ast::MethodCall>(
-                    make_unique<ast::VariableValue>(std::move(names)), std::move(method_name),
-                    std::move(args));
+                return make_unique<ast::MethodCall>(MakeVariableValue(std::move(names)),
+                                                    method_name, std::move(args));
             }
-            if (auto it = declared_classes_.find(method_name); it != declared_classes_.end()) {
-                return make_unique<ast::NewInstance>(
-                    static_cast<const runtime::Class&>(*it->second), std::move(args));  // NOLINT
+            if (const runtime::Class* cls = FindClass(method_name)) {
+                return make_unique<ast::NewInstance>(*cls, std::move(args));
             }
-            if (method_name == "str"sv) {
+            if (method_name.GetName() == "str"sv) {
                 if (args.size() != 1) {
                     throw ParseError("Function str takes exactly one argument"s);
                 }
                 return make_unique<ast::Stringify>(std::move(args.front()));
             }
-            throw ParseError("Unknown call to "s + method_name + "()"s);
+            throw ParseError("Unknown call to "s + method_name.GetName() + "()"s);
+        }
+        return MakeVariableValue(std::move(names));
+    }
+
+    unique_ptr<ast::VariableValue> MakeVariableValue(vector<runtime::Symbol> dotted_ids) {
+        auto result = make_unique<ast::VariableValue>(std::move(dotted_ids));
+        ResolveRead(*result);
+        return result;
+    }
+
+    // Обращается к слоту кадра, если первый идентификатор - известная локальная переменная метода.
+    // Иначе чтение связывается со слотом после разбора тела метода, если имя будет присвоено позже
+    void ResolveRead(ast::VariableValue& read) {
+        if (locals_ == nullptr) {
+            return;
+        }
+        if (auto it = locals_->slots.find(read.GetRootName()); it != locals_->slots.end()) {
+            read.BindSlot(it->second);
+        } else {
+            locals_->unresolved_reads.push_back(&read);
         }
-        return make_unique<ast::VariableValue>(std::move(names));
     }
 
     vector<unique_ptr<ast::Statement>> ParseTestList()  // NOLINT
@@ -323,82 +516,73 @@ private:
                                         std::move(else_body));
     }
 
-    // LogicalExpr -> AndTest [OR AndTest]
-    // AndTest -> NotTest [AND NotTest]
-    // NotTest -> [NOT] NotTest
-    //          | Comparison
-    unique_ptr<ast::Statement> ParseTest()  // NOLINT
+    // Loop -> while LogicalExpr: Suite
+    unique_ptr<ast::Statement> ParseLoop()  // NOLINT
     {
-        auto result = ParseAndTest();
-        while (lexer_.CurrentToken().Is<TokenType::Or>()) {
-            lexer_.NextToken();
-            result = make_unique<ast::Or>(std::move(result), ParseAndTest());
-        }
-        return result;
-    }
+        lexer_.Expect<TokenType::While>();
+        lexer_.NextToken();
 
-    unique_ptr<ast::Statement> ParseAndTest()  // NOLINT
-    {
-        auto result = ParseNotTest();
-        while (lexer_.CurrentToken().Is<TokenType::And>()) {
-            lexer_.NextToken();
-            result = make_unique<ast::And>(std::move(result), ParseNotTest());
-        }
-        return result;
-    }
+        auto condition = ParseTest();
 
-    unique_ptr<ast::Statement> ParseNotTest()  // NOLINT
-    {
-        if (lexer_.CurrentToken().Is<TokenType::Not>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Not>(ParseNotTest());  // NOLINT
-        }
-        return ParseComparison();
+        lexer_.Expect<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        ++loop_depth_;
+        auto body = ParseSuite();
+        --loop_depth_;
+
+        // Между итерациями цикла верхнего уровня других ссылок на объекты, кроме переменных, нет
+        return make_unique<ast::While>(std::move(condition), std::move(body));
     }
 
+    // Выражения разбираются методом Пратта по таблице инфиксных операторов:
+    //
+    // LogicalExpr -> AndTest [OR AndTest]*
+    // AndTest -> NotTest [AND NotTest]*
+    // NotTest -> [NOT] NotTest
+    //          | Comparison
     // Comparison -> Expr [COMP_OP Expr]
-    unique_ptr<ast::Statement> ParseComparison()  // NOLINT
+    // Expr -> Adder ['+'/'-' Adder]*
+    // Adder -> Mult ['*'/'/' Mult]*
+    unique_ptr<ast::Statement> ParseTest()  // NOLINT
     {
-        auto result = ParseExpression();
-
-        const auto tok = lexer_.CurrentToken();
+        return ParseOperators(LOWEST_PRECEDENCE);
+    }
 
-        if (tok == '<') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Less, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok == '>') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Greater, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok.Is<TokenType::Eq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Equal, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok.Is<TokenType::NotEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok.Is<TokenType::LessOrEq>()) {
+    // Разбирает выражение, в котором на верхнем уровне стоят лишь операторы
+    // с приоритетом выше min_precedence
+    unique_ptr<ast::Statement> ParseOperators(int min_precedence)  // NOLINT
+    {
+        unique_ptr<ast::Statement> result;
+        // Приоритет оператора, которым получен result
+        int result_precedence = NOT_PRECEDENCE;
+        if (min_precedence < NOT_PRECEDENCE && lexer_.CurrentToken().Is<TokenType::Not>()) {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok.Is<TokenType::GreaterOrEq>()) {
+            result = make_unique<ast::Not>(ParseOperators(AND_PRECEDENCE));  // NOLINT
+        } else {
+            result = ParseMult();
+            result_precedence = PRIMARY_PRECEDENCE;
+        }
+
+        for (;;) {
+            const InfixOperator* op = FindInfixOperator(lexer_.CurrentToken());
+            // Левый операнд неассоциативного оператора сравнения не может быть сравнением,
+            // а левый операнд оператора не может содержать операторы с меньшим приоритетом
+            if (op == nullptr || op->precedence <= min_precedence
+                || result_precedence < op->precedence
+                || (!op->associative && result_precedence == op->precedence)) {
+                return result;
+            }
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
-                                                ParseExpression());
+            result = op->make(std::move(result), ParseOperators(op->precedence));  // NOLINT
+            result_precedence = op->precedence;
         }
-        return result;
     }
 
     // Statement -> SimpleStatement Newline
     //           | class ClassDefinition
     //           | if Condition
+    //           | while Loop
     unique_ptr<ast::Statement> ParseStatement()  // NOLINT
     {
         const auto& tok = lexer_.CurrentToken();
@@ -410,6 +594,9 @@ private:
         if (tok.Is<TokenType::If>()) {
             return ParseCondition();
         }
+        if (tok.Is<TokenType::While>()) {
+            return ParseLoop();
+        }
         auto result = ParseSimpleStatement();
         lexer_.Expect<TokenType::Newline>();
         lexer_.NextToken();
@@ -418,6 +605,8 @@ private:
 
     // StatementBody -> return Expression
     //               | print ExpressionList
+    //               | break
+    //               | continue
     //               | AssignmentOrCall
     unique_ptr<ast::Statement> ParseSimpleStatement() {
         const auto& tok = lexer_.CurrentToken();
@@ -426,6 +615,17 @@ private:
             lexer_.NextToken();
             return make_unique<ast::Return>(ParseTest());
         }
+        if (tok.Is<TokenType::Break>() || tok.Is<TokenType::Continue>()) {
+            const bool is_break = tok.Is<TokenType::Break>();
+            if (loop_depth_ == 0) {
+                throw ParseError(is_break ? "'break' outside loop"s : "'continue' outside loop"s);
+            }
+            lexer_.NextToken();
+            if (is_break) {
+                return make_unique<ast::Break>();
+            }
+            return make_unique<ast::Continue>();
+        }
         if (tok.Is<TokenType::Print>()) {
             lexer_.NextToken();
             vector<unique_ptr<ast::Statement>> args;
@@ -437,12 +637,201 @@ private:
         return ParseAssignmentOrCall();
     }
 
+    // Область видимости разбираемого метода
+    struct Scope {
+        // Номера слотов локальных переменных
+        std::unordered_map<runtime::Symbol, size_t> slots;
+        // Чтения имён, которым к моменту чтения ещё не было присваивания
+        vector<ast::VariableValue*> unresolved_reads;
+    };
+
     parse::Lexer& lexer_;
     runtime::Closure declared_classes_;
+    // Классы других частей программы при параллельном разборе либо nullptr
+    const ClassRegistry* registry_ = nullptr;
+    size_t chunk_ = 0;
+    vector<runtime::Class*> deferred_classes_;
+    // Область видимости текущего метода либо nullptr на верхнем уровне программы
+    Scope* locals_ = nullptr;
+    // Число циклов, внутри тел которых находится разбираемая инструкция
+    size_t loop_depth_ = 0;
 };
 
+bool IsLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Часть программы, начинающаяся с инструкции верхнего уровня
+struct SourceChunk {
+    string_view text;
+    // Имена классов, объявленных в части, в порядке объявления
+    vector<runtime::Symbol> classes;
+};
+
+// Делит программу на части не меньше min_size байт (кроме последней). Часть начинается
+// со строки без отступа, которая не является веткой else. Текст просматривается по тем же
+// правилам, что и лексером, чтобы не разделить программу внутри строковой константы
+// и найти все объявления классов
+vector<SourceChunk> SplitAtTopLevel(string_view source, size_t min_size) {
+    const parse::scan::Scanner& scanner = parse::scan::GetScanner();
+    const char* const end = source.data() + source.size();
+    const char* chunk_start = source.data();
+    const char* p = chunk_start;
+    vector<SourceChunk> chunks(1);
+    bool line_start = true;
+
+    while (p != end) {
+        const char c = *p;
+        if (line_start) {
+            line_start = false;
+            const bool has_indent = c == ' ' || c == '\n' || c == '#';
+            if (!has_indent && static_cast<size_t>(p - chunk_start) >= min_size) {
+                const char* const word_end = scanner.skip_identifier(p, end);
+                if (string_view(p, word_end - p) != "else"sv) {
+                    chunks.back().text = string_view(chunk_start, p - chunk_start);
+                    chunks.emplace_back();
+                    chunk_start = p;
+                }
+            }
+        }
+
+        if (c == '\n') {
+            line_start = true;
+            ++p;
+        } else if (c == '#') {
+            p = scanner.find_line_end(p, end);
+        } else if (c == '"' || c == '\'') {
+            // Символ после '\\' входит в строку, даже если это кавычка
+            p = scanner.find_quote_or_escape(p + 1, end, c);
+            while (p != end && *p == '\\') {
+                p = scanner.find_quote_or_escape(min(p + 2, end), end, c);
+            }
+            if (p != end) {
+                ++p;
+            }
+        } else if (IsLetter(c)) {
+            const char* const word_end = scanner.skip_identifier(p, end);
+            if (string_view(p, word_end - p) == "class"sv) {
+                const char* const name = scanner.skip_spaces(word_end, end);
+                if (name != end && IsLetter(*name)) {
+                    const char* const name_end = scanner.skip_identifier(name, end);
+                    chunks.back().classes.emplace_back(string_view(name, name_end - name));
+                }
+            }
+            p = word_end;
+        } else if (IsDigit(c)) {
+            while (p != end && IsDigit(*p)) {
+                ++p;
+            }
+        } else {
+            ++p;
+        }
+    }
+    chunks.back().text = string_view(chunk_start, end - chunk_start);
+    return chunks;
+}
+
+// Результат разбора части программы
+struct ParsedChunk {
+    runtime::ArenaPtr arena;
+    unique_ptr<ast::Compound> body;
+    vector<runtime::Class*> deferred_classes;
+    exception_ptr error;
+};
+
+ParsedChunk ParseChunk(const SourceChunk& chunk, const ClassRegistry& registry, size_t index) {
+    ParsedChunk result;
+    result.arena = runtime::Arena::Create();
+    try {
+        runtime::Arena::Scope scope(*result.arena);
+        parse::Lexer lexer(chunk.text);
+        Parser parser(lexer, registry, index);
+        result.body = parser.ParseProgram();
+        result.body->Fold();
+        result.deferred_classes = parser.GetDeferredClasses();
+    } catch (...) {
+        result.error = current_exception();
+    }
+    return result;
+}
+
 }  // namespace
 
 unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
-    return Parser{lexer}.ParseProgram();
-}
\ No newline at end of file
+    // Узлы дерева размещаются подряд в арене программы и освобождаются вместе с ней
+    auto arena = runtime::Arena::Create();
+    unique_ptr<ast::Compound> body;
+    {
+        runtime::Arena::Scope scope(*arena);
+        body = Parser{lexer}.ParseProgram();
+        // Константные выражения вычисляются один раз при разборе, а не при каждом исполнении
+        body->Fold();
+    }
+    return make_unique<ast::Program>(std::move(arena), std::move(body));
+}
+unique_ptr<runtime::Executable> ParseProgramParallel(string_view source, size_t threads,
+                                                     size_t min_chunk_size) {
+    const vector<SourceChunk> chunks = SplitAtTopLevel(source, min_chunk_size);
+    if (chunks.size() == 1) {
+        parse::Lexer lexer(source);
+        return ParseProgram(lexer);
+    }
+
+    // Объекты классов создаются заранее: части программы ссылаются на классы из предыдущих
+    // частей, не дожидаясь их разбора
+    ClassRegistry registry;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        for (runtime::Symbol name : chunks[i].classes) {
+            if (registry.count(name) == 0) {
+                auto cls = runtime::ObjectHolder::Own(runtime::Class(name.GetName(), {}, nullptr));
+                registry.emplace(name, DeclaredClass{std::move(cls), i});
+            }
+        }
+    }
+
+    if (threads == 0) {
+        threads = max(thread::hardware_concurrency(), 1U);
+    }
+    threads = min(threads, chunks.size());
+
+    // Потоки берут очередную неразобранную часть, пока части не закончатся
+    vector<ParsedChunk> parsed(chunks.size());
+    atomic<size_t> next_chunk{0};
+    const auto worker = [&] {
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            parsed[i] = ParseChunk(chunks[i], registry, i);
+        }
+    };
+    vector<thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& t : pool) {
+        t.join();
+    }
+
+    for (const ParsedChunk& chunk : parsed) {
+        if (chunk.error) {
+            rethrow_exception(chunk.error);
+        }
+    }
+
+    // Родители объявлены раньше наследников, поэтому их таблицы методов строятся первыми
+    auto body = make_unique<ast::Compound>();
+    vector<runtime::ArenaPtr> arenas;
+    arenas.reserve(parsed.size());
+    for (ParsedChunk& chunk : parsed) {
+        for (runtime::Class* cls : chunk.deferred_classes) {
+            cls->RebuildMethodTable();
+        }
+        body->Append(std::move(*chunk.body));
+        arenas.push_back(std::move(chunk.arena));
+    }
+    return make_unique<ast::Program>(std::move(arenas), std::move(body));
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
 
 namespace parse {
 class Lexer;
@@ -15,4 +17,15 @@ struct ParseError : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
-std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
\ No newline at end of file
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
+
+// Наименьший размер части программы при параллельном разборе
+inline constexpr size_t PARALLEL_PARSE_CHUNK_SIZE = 64 * 1024;
+
+// Разбирает программу source, разделяя её на части по инструкциям верхнего уровня (строкам
+// без отступа) и разбирая части в threads потоках. При threads == 0 число потоков выбирается
+// по числу ядер процессора. Результат и ошибки разбора совпадают с ParseProgram: если ошибок
+// несколько, выбрасывается ошибка из самой ранней части программы
+std::unique_ptr<runtime::Executable> ParseProgramParallel(
+    std::string_view source, size_t threads = 0,
+    size_t min_chunk_size = PARALLEL_PARSE_CHUNK_SIZE);
@@ -244,6 +244,327 @@ print r, c, t1, t2
                  "Rect(10x20) Circle(52) Triangle(3, 4, 5) Wrong triangle\n"s);
 }
 
+void TestMethodLocals() {
+    const string program = R"(
+x = 'global'
+
+class Accumulator:
+  def __init__(start):
+    total = start
+    self.total = total
+
+  def add(x, times):
+    step = x
+    if times > 1:
+      step = x + self.add(x, times - 1) - self.total
+    self.total = self.total + step
+    return self.total
+
+a = Accumulator(10)
+print a.add(2, 3), x
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "16 global\n"s);
+    ASSERT_EQUAL(closure.count("step"s), 0U);
+    ASSERT_EQUAL(closure.count("total"s), 0U);
+}
+
+void TestMethodLocalsUnassigned() {
+    // Локальная переменная присваивается не на каждом пути исполнения метода
+    const string program = R"(
+class C:
+  def f(c):
+    if c:
+      y = None
+    return y
+
+c = C()
+print c.f(True)
+print c.f(False)
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    ASSERT_THROWS(tree->Execute(closure, context), std::runtime_error);
+    ASSERT_EQUAL(context.output.str(), "None\n"s);
+}
+
+void TestMethodLocalsReadBeforeAssignment() {
+    // В цикле чтение локальной переменной стоит в тексте раньше её присваивания
+    const string program = R"(
+class C:
+  def f():
+    i = 0
+    while i < 4:
+      if i > 1:
+        print y
+      y = i
+      i = i + 1
+    return i
+
+  def g(obj):
+    while obj.n < 2:
+      if obj.n > 0:
+        last.n = obj.n * 10
+      last = obj
+      obj.n = obj.n + 1
+    return last.n
+
+class Box:
+  def __init__():
+    self.n = 0
+
+c = C()
+print c.f()
+print c.g(Box())
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "1\n2\n4\n11\n"s);
+
+    // Без цикла чтение до присваивания по-прежнему ошибка
+    const string straight_line = R"(
+class C:
+  def f():
+    print x
+    x = 1
+
+c = C()
+c.f()
+)"s;
+    runtime::Closure straight_line_closure;
+    auto straight_line_tree = ParseProgramFromString(straight_line);
+    ASSERT_THROWS(straight_line_tree->Execute(straight_line_closure, context), std::runtime_error);
+}
+
+void TestObjectFields() {
+    const string program = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def __eq__(other):
+    return self.x == other.x and self.y == other.y
+
+  def __lt__(other):
+    return self.x < other.x
+
+p = Point(1, 2)
+q = Point(1, 2)
+r = Point(3, 0)
+r.z = 7
+print p == q, p == r, p < r, r.z
+p.y = p.x + r.z
+print p.y, q.y
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "True False True 7\n8 2\n"s);
+}
+
+void TestProgramArena() {
+    const string program = R"(
+class Greeter:
+  def greet(name):
+    return 'Hello, ' + name
+
+g = Greeter()
+print g.greet('arena')
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    {
+        auto tree = ParseProgramFromString(program);
+        const auto* root = dynamic_cast<const ast::Program*>(tree.get());
+        ASSERT(root != nullptr);
+        // Все узлы небольшой программы умещаются в одном блоке арены
+        ASSERT_EQUAL(root->GetArena().GetBlockCount(), 1U);
+        ASSERT(root->GetArena().GetUsedBytes() > 0U);
+        tree->Execute(closure, context);
+    }
+    ASSERT_EQUAL(context.output.str(), "Hello, arena\n"s);
+
+    // Тела методов класса остаются действительными после уничтожения программы
+    auto* greeter = closure.at("g"s).TryAs<runtime::ClassInstance>();
+    auto result = greeter->Call("greet"s, {runtime::ObjectHolder::Own(runtime::String{"again"s})}, context);
+    ASSERT_EQUAL(result.TryAs<runtime::String>()->GetValue(), "Hello, again"s);
+}
+
+void TestConstantFoldingProgram() {
+    const string program = R"(
+class Counter:
+  def value():
+    if 2 * 3 > 5:
+      return -7 + 10
+    return 0
+
+  def broken():
+    return 1 / 0
+
+c = Counter()
+greeting = 'Hello, ' + str(-(2 + 3))
+if not True and c.broken():
+  print 'unreachable'
+else:
+  print greeting, c.value(), -c.value()
+)"s;
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "Hello, -5 3 -3\n"s);
+
+    // Деление на ноль не сворачивается и по-прежнему приводит к ошибке при исполнении
+    auto* counter = closure.at("c"s).TryAs<runtime::ClassInstance>();
+    ASSERT_THROWS(counter->Call("broken"s, {}, context), std::runtime_error);
+}
+
+void TestLoopControlOutsideLoop() {
+    ASSERT_THROWS(ParseProgramFromString("break\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString("if True:\n  continue\n"s), ParseError);
+    // Тело метода не находится внутри цикла, в котором объявлен класс
+    const string method_in_loop = R"(
+while True:
+  class Breaker:
+    def run():
+      break
+  break
+)"s;
+    ASSERT_THROWS(ParseProgramFromString(method_in_loop), ParseError);
+    ASSERT(ParseProgramFromString("while True:\n  if True:\n    break\n"s) != nullptr);
+}
+
+void TestOperatorPrecedence() {
+    const string program = R"(
+a = 7
+b = 2
+print a - b - 1, a / b / 2, 1 + a * b - 8 / b, -a * b, (1 + 2) * -(a - b)
+print not a == b and b < a or False, not not b > a, (a > b) == True
+print 1 < 2 and 2 < 3, a + b >= 9 and not a * b != 14
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "4 1 11 -14 -15\nTrue False True\nTrue True\n"s);
+
+    // Операторы сравнения не объединяются в цепочки, а not не может быть операндом арифметики
+    ASSERT_THROWS(ParseProgramFromString("x = 1 < 2 < 3\n"s), LexerError);
+    ASSERT_THROWS(ParseProgramFromString("x = True and 1 < 2 == True\n"s), LexerError);
+    ASSERT_THROWS(ParseProgramFromString("x = 1 + not 2\n"s), LexerError);
+    ASSERT_THROWS(ParseProgramFromString("x = 1 < not 2\n"s), LexerError);
+}
+
+// Исполняет программу, разобранную параллельно по частям из отдельных инструкций
+string RunParallel(const string& program, size_t threads) {
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    auto tree = ParseProgramParallel(program, threads, 1);
+    tree->Execute(closure, context);
+    return context.output.str();
+}
+
+void TestParallelParse() {
+    const string program = R"(
+# Классы объявлены в разных частях программы
+class Shape:
+  def __init__(name):
+    self.name = name
+
+  def __str__():
+    return self.name + '(' + str(self.area()) + ')'
+
+  def area():
+    return 0
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.name = "rect"
+    self.w = w
+    self.h = h
+
+  def area():
+    return self.w * self.h
+s = 'строка с кавычкой \' и переводом
+class NotAClass:
+'
+class Square(Rect):
+  def __init__(side):
+    self.name = 'square'
+    self.w = side
+    self.h = side
+sq = Square(3)
+if sq.area() > 5:
+  print sq, Rect(2, 5)
+else:
+  print 'small'
+x = 0
+while x < 3:
+  x = x + 1
+print x, Shape('shape'), s
+)"s;
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    ParseProgramFromString(program)->Execute(closure, context);
+    const string expected = context.output.str();
+    ASSERT_EQUAL(expected,
+                 "square(9) rect(10)\n3 shape(0) строка с кавычкой ' и переводом\nclass NotAClass:\n\n"s);
+    for (const size_t threads : {1U, 2U, 4U, 16U}) {
+        ASSERT_EQUAL(RunParallel(program, threads), expected);
+    }
+
+    auto tree = ParseProgramParallel(program, 4, 1);
+    const auto* root = dynamic_cast<const ast::Program*>(tree.get());
+    ASSERT(root != nullptr);
+    ASSERT(root->GetArenaCount() > 5U);
+    // Небольшая программа разбирается одной частью
+    tree = ParseProgramParallel(program);
+    root = dynamic_cast<const ast::Program*>(tree.get());
+    ASSERT_EQUAL(root->GetArenaCount(), 1U);
+}
+
+void TestParallelParseErrors() {
+    // Класс нельзя использовать до объявления, даже если он объявлен в другой части программы
+    const string use_before_declaration = "x = Late()\nclass Late:\n  def f():\n    return 1\n"s;
+    ASSERT_THROWS(ParseProgramParallel(use_before_declaration, 2, 1), ParseError);
+    const string base_after_derived = "class Derived(Base):\n  def f():\n    return 1\n"s
+                                    + "class Base:\n  def g():\n    return 2\n"s;
+    ASSERT_THROWS(ParseProgramParallel(base_after_derived, 2, 1), ParseError);
+    const string duplicate = "class A:\n  def f():\n    return 1\nx = 1\n"s
+                           + "class A:\n  def f():\n    return 2\n"s;
+    ASSERT_THROWS(ParseProgramParallel(duplicate, 2, 1), ParseError);
+
+    // Из нескольких ошибок выбрасывается первая в тексте программы
+    const string two_errors = "x = 1\ny = $\nz = 2\nprint Unknown()\n"s;
+    ASSERT_THROWS(ParseProgramParallel(two_errors, 4, 1), LexerError);
+}
+
 }  // namespace parse
 
 void TestParseProgram(TestRunner& tr) {
@@ -254,5 +575,15 @@ void TestParseProgram(TestRunner& tr) {
     RUN_TEST(tr, parse::TestRecursion);
     RUN_TEST(tr, parse::TestRecursion2);
     RUN_TEST(tr, parse::TestComplexLogicalExpression);
+    RUN_TEST(tr, parse::TestOperatorPrecedence);
     RUN_TEST(tr, parse::TestClassicalPolymorphism);
+    RUN_TEST(tr, parse::TestMethodLocals);
+    RUN_TEST(tr, parse::TestMethodLocalsUnassigned);
+    RUN_TEST(tr, parse::TestMethodLocalsReadBeforeAssignment);
+    RUN_TEST(tr, parse::TestObjectFields);
+    RUN_TEST(tr, parse::TestProgramArena);
+    RUN_TEST(tr, parse::TestConstantFoldingProgram);
+    RUN_TEST(tr, parse::TestLoopControlOutsideLoop);
+    RUN_TEST(tr, parse::TestParallelParse);
+    RUN_TEST(tr, parse::TestParallelParseErrors);
 }
\ No newline at end of file
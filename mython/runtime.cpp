@@ -1,5 +1,8 @@
 #include "runtime.h"
 
+#include "arena.h"
+#include "gc.h"
+
 #include <cassert>
 #include <optional>
 #include <sstream>
@@ -9,17 +12,82 @@ using namespace std;
 
 namespace runtime {
 
-ObjectHolder::ObjectHolder(std::shared_ptr<Object> data)
+namespace {
+const Symbol SELF_SYMBOL = "self"sv;
+const Symbol STR_METHOD = "__str__"sv;
+const Symbol EQ_METHOD = "__eq__"sv;
+const Symbol LT_METHOD = "__lt__"sv;
+const Symbol ADD_METHOD = "__add__"sv;
+
+// Возвращает значение объекта, вид которого уже проверен
+template <typename T>
+const auto& ValueOf(const ObjectHolder& object) {
+    return static_cast<const T&>(*object).GetValue();
+}
+
+// Неизменяемые строки, на которые ссылаются результаты Stringify. Никогда не удаляются
+class ImmortalStrings {
+public:
+    static ImmortalStrings& Instance() {
+        static ImmortalStrings* const strings = new ImmortalStrings();
+        return *strings;
+    }
+
+    ObjectHolder Bool(bool value) {
+        return ObjectHolder::Share(value ? true_ : false_);
+    }
+
+    ObjectHolder None() {
+        return ObjectHolder::Share(none_);
+    }
+
+    // Возвращает представление числа либо пустой ObjectHolder, если число не входит в кэш
+    ObjectHolder SmallInt(int value) {
+        if (value < SMALL_INT_MIN || value > SMALL_INT_MAX) {
+            return {};
+        }
+        return ObjectHolder::Share(small_ints_[value - SMALL_INT_MIN]);
+    }
+
+private:
+    ImmortalStrings() {
+        static_assert(SMALL_INT_MIN <= SMALL_INT_MAX);
+        small_ints_.reserve(SMALL_INT_MAX - SMALL_INT_MIN + 1);
+        for (int value = SMALL_INT_MIN; value <= SMALL_INT_MAX; ++value) {
+            small_ints_.emplace_back(std::to_string(value));
+        }
+    }
+
+    String true_{"True"s};
+    String false_{"False"s};
+    String none_{"None"s};
+    std::vector<String> small_ints_;
+};
+
+// Вызывает метод сравнения method экземпляра lhs, если он определён
+std::optional<bool> CallComparisonMethod(const ObjectHolder& lhs, const ObjectHolder& rhs,
+                                         Symbol method, Context& context) {
+    auto& instance = static_cast<ClassInstance&>(*lhs);
+    if (!instance.HasMethod(method, 1)) {
+        return std::nullopt;
+    }
+    return instance.Call(method, {rhs}, context).TryAs<Bool>()->GetValue();
+}
+}  // namespace
+
+ObjectHolder::ObjectHolder(Data data)
     : data_(std::move(data)) {
 }
 
 void ObjectHolder::AssertIsValid() const {
-    assert(data_ != nullptr);
+    assert(Get() != nullptr);
 }
 
 ObjectHolder ObjectHolder::Share(Object& object) {
-    // Р’РѕР·РІСЂР°С‰Р°РµРј РЅРµРІР»Р°РґРµСЋС‰РёР№ shared_ptr (РµРіРѕ deleter РЅРёС‡РµРіРѕ РЅРµ РґРµР»Р°РµС‚)
-    return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
+    if (object.GetRefCount() > 0) {
+        return ObjectHolder(Data(std::in_place_index<OWNED>, &object));
+    }
+    return ObjectHolder(Data(&object));
 }
 
 ObjectHolder ObjectHolder::None() {
@@ -36,31 +104,21 @@ Object* ObjectHolder::operator->() const {
     return Get();
 }
 
-Object* ObjectHolder::Get() const {
-    return data_.get();
-}
-
-ObjectHolder::operator bool() const {
-    return Get() != nullptr;
-}
-
 bool IsTrue(const ObjectHolder& object) {
-    if (object) {
-        if (String* str = object.TryAs<String>(); str != nullptr) {
-            return str->GetValue().size() != 0;
-        } else if (Number* i = object.TryAs<Number>(); i != nullptr) {
-            return i->GetValue() != 0;
-        } else if (Bool* b = object.TryAs<Bool>(); b != nullptr) {
-            return b->GetValue() == true;
-        }
+    switch (object.GetKind()) {
+        case ObjectKind::String:
+            return !ValueOf<String>(object).empty();
+        case ObjectKind::Number:
+            return ValueOf<Number>(object) != 0;
+        case ObjectKind::Bool:
+            return ValueOf<Bool>(object);
+        default:
+            return false;
     }
-
-    return false;
-
 }
 
 void ClassInstance::Print(std::ostream& os, Context& context) {
-    auto method_ptr = this->class_.GetMethod("__str__"s);
+    auto method_ptr = this->class_.GetMethod(STR_METHOD);
 
     if (method_ptr != nullptr) {
         Call(method_ptr->name, {}, context)->Print(os, context);
@@ -69,7 +127,7 @@ void ClassInstance::Print(std::ostream& os, Context& context) {
     }
 }
 
-bool ClassInstance::HasMethod(const std::string& method, size_t argument_count) const {
+bool ClassInstance::HasMethod(Symbol method, size_t argument_count) const {
     if (const Method* method__ = class_.GetMethod(method); method__ != nullptr) {
         if (method__->formal_params.size() == argument_count) {
             return true;
@@ -79,55 +137,227 @@ bool ClassInstance::HasMethod(const std::string& method, size_t argument_count)
     return false;
 }
 
-Closure& ClassInstance::Fields() {
+const Class& ClassInstance::GetClass() const {
+    return class_;
+}
+
+FieldTable& ClassInstance::Fields() {
     return fields_;
 }
 
-const Closure& ClassInstance::Fields() const {
+const FieldTable& ClassInstance::Fields() const {
     return fields_;
 }
 
+const Shape* Shape::Empty() {
+    static const Shape* const empty = new Shape();
+    return empty;
+}
+
+size_t Shape::Find(Symbol name) const {
+    if (auto it = offsets_.find(name); it != offsets_.end()) {
+        return it->second;
+    }
+    return NO_FIELD;
+}
+
+const Shape* Shape::AddField(Symbol name) const {
+    assert(Find(name) == NO_FIELD);
+    auto& next = transitions_[name];
+    if (!next) {
+        next.reset(new Shape());
+        next->names_ = names_;
+        next->names_.push_back(name);
+        next->offsets_ = offsets_;
+        next->offsets_.emplace(name, names_.size());
+    }
+    return next.get();
+}
+
+ObjectHolder& FieldTable::operator[](Symbol name) {
+    if (const size_t offset = shape_->Find(name); offset != Shape::NO_FIELD) {
+        return values_[offset];
+    }
+    return Append(shape_->AddField(name));
+}
+
+ObjectHolder& FieldTable::at(Symbol name) {
+    if (const size_t offset = shape_->Find(name); offset != Shape::NO_FIELD) {
+        return values_[offset];
+    }
+    throw out_of_range("No field "s + name.GetName());
+}
+
+const ObjectHolder& FieldTable::at(Symbol name) const {
+    return const_cast<FieldTable&>(*this).at(name);
+}
+
+FieldTable::iterator FieldTable::find(Symbol name) {
+    const size_t offset = shape_->Find(name);
+    return {this, offset != Shape::NO_FIELD ? offset : values_.size()};
+}
+
+FieldTable::const_iterator FieldTable::find(Symbol name) const {
+    const size_t offset = shape_->Find(name);
+    return {this, offset != Shape::NO_FIELD ? offset : values_.size()};
+}
+
+size_t FieldTable::count(Symbol name) const {
+    return shape_->Find(name) != Shape::NO_FIELD ? 1 : 0;
+}
+
+ObjectHolder& FieldTable::Append(const Shape* shape) {
+    assert(shape->GetFieldCount() == values_.size() + 1);
+    shape_ = shape;
+    return values_.emplace_back();
+}
+
+void FieldTable::clear() {
+    // Значения разрушаются после того, как таблица стала пустой
+    const std::vector<ObjectHolder> values = std::move(values_);
+    values_.clear();
+    shape_ = Shape::Empty();
+}
+
+ObjectHolder& FieldCache::Get(FieldTable& fields, Symbol name) {
+    const Shape* shape = fields.GetShape();
+    if (shape == shape_) {
+        return fields.Slot(offset_);
+    }
+    if (shape == transition_from_) {
+        return fields.Append(transition_to_);
+    }
+
+    if (const size_t offset = shape->Find(name); offset != Shape::NO_FIELD) {
+        shape_ = shape;
+        offset_ = offset;
+        return fields.Slot(offset);
+    }
+
+    transition_from_ = shape;
+    transition_to_ = shape->AddField(name);
+    return fields.Append(transition_to_);
+}
+
+void* Executable::operator new(size_t size) {
+    return Arena::AllocateNode(size);
+}
+
+void Executable::operator delete(void* node) noexcept {
+    Arena::FreeNode(node);
+}
+
+std::unique_ptr<Executable> Executable::Fold() {
+    return nullptr;
+}
+
 ClassInstance::ClassInstance(const Class& cls) : class_(cls) {
-    fields_["self"] = ObjectHolder::Share(*this);
+    SetKind(ObjectKind::ClassInstance);
 }
 
-ObjectHolder ClassInstance::Call(const std::string& method,
+ObjectHolder ClassInstance::Call(Symbol method,
                                      const std::vector<ObjectHolder>& actual_args,
                                      Context& context) {
-    if (!HasMethod(method, actual_args.size())) {
+    const Method* method_ptr = class_.GetMethod(method);
+    if (method_ptr == nullptr || method_ptr->formal_params.size() != actual_args.size()) {
         throw std::runtime_error("Not implemented"s);
     }
 
-    auto* method_ptr = class_.GetMethod(method);
-    Closure closure;
+    return Call(*method_ptr, actual_args, context);
+}
 
-    closure["self"s] = ObjectHolder::Share(*this);
+ObjectHolder ClassInstance::Call(const Method& method, const std::vector<ObjectHolder>& actual_args,
+                                 Context& context) {
+    Closure closure;
+    // Кадр метода - корень кучи, пока метод исполняется
+    std::optional<GcHeap::Root> root;
+    if (GcHeap* heap = GcHeap::GetCurrent()) {
+        root.emplace(*heap, closure);
+    }
 
-    for (size_t i = 0; i < actual_args.size(); ++i) {
-        closure[method_ptr->formal_params[i]] = actual_args[i];
+    if (method.frame_size != 0) {
+        closure.AllocateFrame(method.frame_size);
+        closure.Slot(0) = ObjectHolder::Share(*this);
+        for (size_t i = 0; i < actual_args.size(); ++i) {
+            closure.Slot(i + 1) = actual_args[i];
+        }
+    } else {
+        closure[SELF_SYMBOL] = ObjectHolder::Share(*this);
+        for (size_t i = 0; i < actual_args.size(); ++i) {
+            closure[method.formal_params[i]] = actual_args[i];
+        }
     }
 
-    return method_ptr->body->Execute(closure, context);
+    // Вход в метод - безопасная точка: объект и аргументы уже в кадре, а промежуточные
+    // значения вызывающего кода закреплены
+    GcHeap::SafePoint();
+    return method.body->Execute(closure, context);
 }
 
 Class::Class(std::string name, std::vector<Method> methods, const Class* parent) : name_(std::move(name)), methods_(std::move(methods)), parent_(parent) {
+    SetKind(ObjectKind::Class);
+    RebuildMethodTable();
+}
 
+void Class::RebuildMethodTable() {
+    method_table_.clear();
+    if (parent_ != nullptr) {
+        method_table_.reserve(parent_->method_table_.size() + methods_.size());
+    }
+    // При совпадении имён побеждает первый из методов класса, как и при линейном поиске
+    for (const auto& method : methods_) {
+        method_table_.try_emplace(method.name, &method);
+    }
+    if (parent_ != nullptr) {
+        for (const auto& [name, method] : parent_->method_table_) {
+            method_table_.try_emplace(name, method);
+        }
+    }
+    InvalidateMethodCaches();
 }
 
-const Method* Class::GetMethod(const std::string& name) const {
-    const Class* current_class = this;
+const Method* Class::GetMethod(Symbol name) const {
+    if (auto it = method_table_.find(name); it != method_table_.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
 
-    do {
-        for (const auto& method : current_class->methods_) {
-            if (method.name == name) {
-                return &method;
-            }
+std::atomic<std::uint64_t> Class::methods_epoch_{0};
+
+std::uint64_t Class::GetMethodsEpoch() {
+    return methods_epoch_.load(std::memory_order_relaxed);
+}
+
+void Class::InvalidateMethodCaches() {
+    methods_epoch_.fetch_add(1, std::memory_order_relaxed);
+}
+
+const Method* MethodCache::Lookup(const Class& cls, Symbol name, size_t argument_count) {
+    if (const std::uint64_t epoch = Class::GetMethodsEpoch(); epoch != epoch_) {
+        size_ = 0;
+        next_victim_ = 0;
+        epoch_ = epoch;
+    }
+
+    for (size_t i = 0; i < size_; ++i) {
+        if (entries_[i].cls == &cls) {
+            return entries_[i].method;
         }
+    }
 
-        current_class = current_class->parent_;
-    } while (current_class != nullptr);
+    const Method* method = cls.GetMethod(name);
+    if (method == nullptr || method->formal_params.size() != argument_count) {
+        return nullptr;
+    }
 
-    return nullptr;
+    if (size_ < CAPACITY) {
+        entries_[size_++] = {&cls, method};
+    } else {
+        entries_[next_victim_] = {&cls, method};
+        next_victim_ = (next_victim_ + 1) % CAPACITY;
+    }
+    return method;
 }
 
 [[nodiscard]] const std::string& Class::GetName() const {
@@ -142,72 +372,50 @@ void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
     os << (GetValue() ? "True"sv : "False"sv);
 }
 
-bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-    if (ClassInstance* item_1 = lhs.TryAs<ClassInstance>(); item_1 != nullptr) {
-        if (ClassInstance* item_2 = rhs.TryAs<ClassInstance>(); item_2 != nullptr) {
-            if (item_1->HasMethod("__eq__", 1)) {
-
-                std::vector<ObjectHolder> fields;
-                for (const auto& field : item_2->Fields()) {
-                    fields.push_back(field.second);
-                }
-
-                return (item_1->Call("__eq__", fields, context)).TryAs<Bool>()->GetValue();
+void Unbound::Print(std::ostream& os, [[maybe_unused]] Context& context) {
+    os << "<unbound>"sv;
+}
 
+bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    switch (KindPair(lhs.GetKind(), rhs.GetKind())) {
+        case KindPair(ObjectKind::ClassInstance, ObjectKind::ClassInstance):
+            if (auto result = CallComparisonMethod(lhs, rhs, EQ_METHOD, context)) {
+                return *result;
             }
-        }
-    } else if (const String* item_1 = lhs.TryAs<String>(); item_1 != nullptr) {
-        if (String* item_2 = rhs.TryAs<String>(); item_2 != nullptr) {
-            return item_1->GetValue() == item_2->GetValue();
-        }
-
-    } else if (const Number* item_1 = lhs.TryAs<Number>(); item_1 != nullptr) {
-        if (Number* item_2 = rhs.TryAs<Number>(); item_2 != nullptr) {
-            return item_1->GetValue() == item_2->GetValue();
-        }
-    } else if (const Bool* item_1 = lhs.TryAs<Bool>(); item_1 != nullptr) {
-        if (Bool* item_2 = rhs.TryAs<Bool>(); item_2 != nullptr) {
-            return item_1->GetValue() == item_2->GetValue();
-        }
-    } else if (lhs.Get() == nullptr && rhs.Get() == nullptr) {
-        return true;
+            break;
+        case KindPair(ObjectKind::String, ObjectKind::String):
+            return ValueOf<String>(lhs) == ValueOf<String>(rhs);
+        case KindPair(ObjectKind::Number, ObjectKind::Number):
+            return ValueOf<Number>(lhs) == ValueOf<Number>(rhs);
+        case KindPair(ObjectKind::Bool, ObjectKind::Bool):
+            return ValueOf<Bool>(lhs) == ValueOf<Bool>(rhs);
+        case KindPair(ObjectKind::None, ObjectKind::None):
+            return true;
+        default:
+            break;
     }
 
     throw runtime_error("Equal_get_bad_items_to_compare");
-
 }
 
 bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-    if (ClassInstance* item_1 = lhs.TryAs<ClassInstance>(); item_1 != nullptr) {
-        if (ClassInstance* item_2 = rhs.TryAs<ClassInstance>(); item_2 != nullptr) {
-            if (item_1->HasMethod("__lt__", 1)) {
-
-                std::vector<ObjectHolder> fields;
-                for (const auto& field : item_2->Fields()) {
-                    fields.push_back(field.second);
-                }
-
-                return (item_1->Call("__lt__", fields, context)).TryAs<Bool>()->GetValue();
-
+    switch (KindPair(lhs.GetKind(), rhs.GetKind())) {
+        case KindPair(ObjectKind::ClassInstance, ObjectKind::ClassInstance):
+            if (auto result = CallComparisonMethod(lhs, rhs, LT_METHOD, context)) {
+                return *result;
             }
-        }
-    } else if (const String* item_1 = lhs.TryAs<String>(); item_1 != nullptr) {
-        if (String* item_2 = rhs.TryAs<String>(); item_2 != nullptr) {
-            return item_1->GetValue() < item_2->GetValue();
-        }
-
-    } else if (const Number* item_1 = lhs.TryAs<Number>(); item_1 != nullptr) {
-        if (Number* item_2 = rhs.TryAs<Number>(); item_2 != nullptr) {
-            return item_1->GetValue() < item_2->GetValue();
-        }
-    } else if (const Bool* item_1 = lhs.TryAs<Bool>(); item_1 != nullptr) {
-        if (Bool* item_2 = rhs.TryAs<Bool>(); item_2 != nullptr) {
-            return item_1->GetValue() < item_2->GetValue();
-        }
+            break;
+        case KindPair(ObjectKind::String, ObjectKind::String):
+            return ValueOf<String>(lhs) < ValueOf<String>(rhs);
+        case KindPair(ObjectKind::Number, ObjectKind::Number):
+            return ValueOf<Number>(lhs) < ValueOf<Number>(rhs);
+        case KindPair(ObjectKind::Bool, ObjectKind::Bool):
+            return ValueOf<Bool>(lhs) < ValueOf<Bool>(rhs);
+        default:
+            break;
     }
 
     throw runtime_error("Less_get_bad_items_to_compare");
-
 }
 
 bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
@@ -226,4 +434,89 @@ bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& c
     return !Less(lhs, rhs, context);
 }
 
+ObjectHolder Add(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    switch (KindPair(lhs.GetKind(), rhs.GetKind())) {
+        case KindPair(ObjectKind::Number, ObjectKind::Number):
+            return ObjectHolder::Own(Number(ValueOf<Number>(lhs) + ValueOf<Number>(rhs)));
+        case KindPair(ObjectKind::String, ObjectKind::String):
+            return ObjectHolder::Own(String(ValueOf<String>(lhs) + ValueOf<String>(rhs)));
+        default:
+            if (lhs.GetKind() == ObjectKind::ClassInstance) {
+                auto& instance = static_cast<ClassInstance&>(*lhs);
+                if (instance.HasMethod(ADD_METHOD, 1)) {
+                    return instance.Call(ADD_METHOD, {rhs}, context);
+                }
+            }
+            break;
+    }
+
+    throw std::runtime_error("Bad_Add");
+}
+
+ObjectHolder Sub(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+    if (KindPair(lhs.GetKind(), rhs.GetKind()) == KindPair(ObjectKind::Number, ObjectKind::Number)) {
+        return ObjectHolder::Own(Number(ValueOf<Number>(lhs) - ValueOf<Number>(rhs)));
+    }
+
+    throw std::runtime_error("Bad_sub");
+}
+
+ObjectHolder Mult(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+    if (KindPair(lhs.GetKind(), rhs.GetKind()) == KindPair(ObjectKind::Number, ObjectKind::Number)) {
+        return ObjectHolder::Own(Number(ValueOf<Number>(lhs) * ValueOf<Number>(rhs)));
+    }
+
+    throw std::runtime_error("Bad_mult");
+}
+
+ObjectHolder Div(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+    if (KindPair(lhs.GetKind(), rhs.GetKind()) == KindPair(ObjectKind::Number, ObjectKind::Number)
+        && ValueOf<Number>(rhs) != 0) {
+        return ObjectHolder::Own(Number(ValueOf<Number>(lhs) / ValueOf<Number>(rhs)));
+    }
+
+    throw std::runtime_error("Bad_div");
+}
+
+ObjectHolder Stringify(const ObjectHolder& object, Context& context) {
+    switch (object.GetKind()) {
+        case ObjectKind::String:
+            return ObjectHolder::Own(String(ValueOf<String>(object)));
+        case ObjectKind::Number: {
+            const int value = ValueOf<Number>(object);
+            if (ObjectHolder cached = ImmortalStrings::Instance().SmallInt(value)) {
+                return cached;
+            }
+            return ObjectHolder::Own(String(std::to_string(value)));
+        }
+        case ObjectKind::Bool:
+            return ImmortalStrings::Instance().Bool(ValueOf<Bool>(object));
+        case ObjectKind::None:
+            return ImmortalStrings::Instance().None();
+        case ObjectKind::ClassInstance: {
+            auto& instance = static_cast<ClassInstance&>(*object);
+            if (instance.HasMethod(STR_METHOD, 0)) {
+                ObjectHolder new_object = instance.Call(STR_METHOD, {}, context);
+                switch (new_object.GetKind()) {
+                    case ObjectKind::None:
+                    case ObjectKind::String:
+                    case ObjectKind::Number:
+                    case ObjectKind::Bool:
+                        return Stringify(new_object, context);
+                    default:
+                        break;
+                }
+            }
+
+            stringstream ss;
+            ss << &instance;
+            return ObjectHolder::Own(String(ss.str()));
+        }
+        default:
+            break;
+    }
+
+    throw std::runtime_error("Bad_stringify");
+}
+
 }  // namespace runtime
@@ -1,11 +1,24 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#include "object_pool.h"
+#include "symbol.h"
+
+namespace bytecode {
+class Compiler;
+}  // namespace bytecode
+
 namespace runtime {
 
 // Контекст исполнения инструкций Mython
@@ -18,29 +31,306 @@ protected:
     ~Context() = default;
 };
 
+// Вид объекта. Позволяет проверять тип объекта и выбирать операцию без dynamic_cast
+enum class ObjectKind : std::uint8_t {
+    None,           // пустой ObjectHolder
+    Other,          // объекты, тип которых определяется через dynamic_cast
+    String,
+    Number,
+    Bool,
+    Class,
+    ClassInstance,
+};
+
+#ifndef MYTHON_ATOMIC_REFCOUNT
+#define MYTHON_ATOMIC_REFCOUNT 0
+#endif
+
+/*
+ * Заголовок объекта: вид объекта, флаги кучи GcHeap и счётчик владеющих ObjectHolder,
+ * упакованные в 32 бита.
+ * По умолчанию счётчик не атомарный: интерпретатор работает с объектами из одного потока.
+ * Для разделения объектов между потоками интерпретатор собирается с MYTHON_ATOMIC_REFCOUNT=1.
+ * Объект, число ссылок на который достигло IMMORTAL_REFS, становится бессмертным:
+ * его счётчик больше не меняется и объект не удаляется
+ */
+class ObjectHeader {
+public:
+    static constexpr bool ATOMIC = MYTHON_ATOMIC_REFCOUNT != 0;
+    static constexpr std::uint32_t IMMORTAL_REFS = 1U << 23;
+
+    ObjectHeader() = default;
+
+    // Копия объекта получает вид оригинала, но не его владельцев
+    ObjectHeader(const ObjectHeader& other) noexcept
+        : bits_(static_cast<std::uint32_t>(other.GetKind())) {
+    }
+
+    ObjectHeader& operator=(const ObjectHeader& /*other*/) noexcept {
+        return *this;
+    }
+
+    [[nodiscard]] ObjectKind GetKind() const {
+        return static_cast<ObjectKind>(Load() & KIND_MASK);
+    }
+
+    // Вызывается только из конструкторов, пока на объект нет ссылок
+    void SetKind(ObjectKind kind) {
+        Store((Load() & ~KIND_MASK) | static_cast<std::uint32_t>(kind));
+    }
+
+    [[nodiscard]] std::uint32_t GetRefCount() const {
+        return Load() >> KIND_BITS;
+    }
+
+    // Передаёт управление временем жизни объекта куче GcHeap: счётчик ссылок становится бессмертным
+    void SetManaged() {
+        Store((Load() & KIND_MASK) | MANAGED_BIT | IMMORTAL_REFS << KIND_BITS);
+    }
+
+    [[nodiscard]] bool IsManaged() const {
+        return (Load() & MANAGED_BIT) != 0;
+    }
+
+    // Отметка достижимости, которую ставит GcHeap во время сборки
+    [[nodiscard]] bool IsMarked() const {
+        return (Load() & MARK_BIT) != 0;
+    }
+
+    void SetMarked(bool marked) {
+        Store(marked ? Load() | MARK_BIT : Load() & ~MARK_BIT);
+    }
+
+    void AddRef() {
+        if (GetRefCount() >= IMMORTAL_REFS) {
+            return;
+        }
+#if MYTHON_ATOMIC_REFCOUNT
+        bits_.fetch_add(ONE_REF, std::memory_order_relaxed);
+#else
+        bits_ += ONE_REF;
+#endif
+    }
+
+    // Возвращает true, если удалена последняя ссылка и объект нужно удалить
+    [[nodiscard]] bool Release() {
+        if (GetRefCount() >= IMMORTAL_REFS) {
+            return false;
+        }
+#if MYTHON_ATOMIC_REFCOUNT
+        return bits_.fetch_sub(ONE_REF, std::memory_order_acq_rel) >> KIND_BITS == 1;
+#else
+        bits_ -= ONE_REF;
+        return bits_ >> KIND_BITS == 0;
+#endif
+    }
+
+private:
+    // Младший байт: вид объекта и два флага кучи GcHeap
+    static constexpr std::uint32_t KIND_BITS = 8;
+    static constexpr std::uint32_t MARK_BIT = 1U << 7;
+    static constexpr std::uint32_t MANAGED_BIT = 1U << 6;
+    static constexpr std::uint32_t KIND_MASK = MANAGED_BIT - 1;
+    static_assert(static_cast<std::uint32_t>(ObjectKind::ClassInstance) <= KIND_MASK);
+    static constexpr std::uint32_t ONE_REF = 1U << KIND_BITS;
+
+    [[nodiscard]] std::uint32_t Load() const {
+#if MYTHON_ATOMIC_REFCOUNT
+        return bits_.load(std::memory_order_relaxed);
+#else
+        return bits_;
+#endif
+    }
+
+    void Store(std::uint32_t bits) {
+#if MYTHON_ATOMIC_REFCOUNT
+        bits_.store(bits, std::memory_order_relaxed);
+#else
+        bits_ = bits;
+#endif
+    }
+
+#if MYTHON_ATOMIC_REFCOUNT
+    std::atomic<std::uint32_t> bits_ = static_cast<std::uint32_t>(ObjectKind::Other);
+#else
+    std::uint32_t bits_ = static_cast<std::uint32_t>(ObjectKind::Other);
+#endif
+};
+
 // Базовый класс для всех объектов языка Mython
 class Object {
 public:
     virtual ~Object() = default;
     // выводит в os своё представление в виде строки
     virtual void Print(std::ostream& os, Context& context) = 0;
+
+    [[nodiscard]] ObjectKind GetKind() const {
+        return header_.GetKind();
+    }
+
+    // Возвращает число владеющих объектом ObjectHolder
+    [[nodiscard]] std::uint32_t GetRefCount() const {
+        return header_.GetRefCount();
+    }
+
+    // Объекты в куче размещаются в пулах object_pool
+    static void* operator new(size_t size) {
+        return object_pool::Allocate(size);
+    }
+
+    static void operator delete(void* object, size_t size) noexcept {
+        object_pool::Free(object, size);
+    }
+
+protected:
+    // Задаётся в конструкторах наследников, вид которых известен
+    void SetKind(ObjectKind kind) {
+        header_.SetKind(kind);
+    }
+
+private:
+    friend class ObjectHolder;
+    friend class GcHeap;
+
+    ObjectHeader header_;
+};
+
+template <typename T>
+class ValueObject;
+class Bool;
+class Class;
+class ClassInstance;
+
+// Начинает отслеживать экземпляр класса, только что размещённый в куче, в сборщике циклов
+// текущего потока (см. collector.h)
+void TrackInstance(ClassInstance& instance);
+
+// Передаёт объект, только что размещённый в куче, текущей куче GcHeap (см. gc.h).
+// Возвращает false, если кучи нет и временем жизни объекта управляет счётчик ссылок
+bool AdoptObject(Object& object);
+
+// Вид объектов класса T. Для классов со значением ObjectKind::Other ObjectHolder::TryAs
+// использует dynamic_cast
+template <typename T>
+inline constexpr ObjectKind KIND_OF = ObjectKind::Other;
+template <>
+inline constexpr ObjectKind KIND_OF<ValueObject<std::string>> = ObjectKind::String;
+template <>
+inline constexpr ObjectKind KIND_OF<ValueObject<int>> = ObjectKind::Number;
+template <>
+inline constexpr ObjectKind KIND_OF<Bool> = ObjectKind::Bool;
+template <>
+inline constexpr ObjectKind KIND_OF<Class> = ObjectKind::Class;
+template <>
+inline constexpr ObjectKind KIND_OF<ClassInstance> = ObjectKind::ClassInstance;
+
+// Объединяет виды двух операндов в одно значение для выбора бинарной операции оператором switch
+constexpr int KindPair(ObjectKind lhs, ObjectKind rhs) {
+    return static_cast<int>(lhs) << 8 | static_cast<int>(rhs);
+}
+
+// Объект-значение, хранящий значение типа T
+template <typename T>
+class ValueObject : public Object {
+public:
+    ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+        : value_(v) {
+        SetKind(KIND_OF<ValueObject>);
+    }
+
+    void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
+        os << value_;
+    }
+
+    [[nodiscard]] const T& GetValue() const {
+        return value_;
+    }
+
+private:
+    T value_;
 };
 
-// Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе
+// Строковое значение
+using String = ValueObject<std::string>;
+// Числовое значение
+using Number = ValueObject<int>;
+
+// Логическое значение
+class Bool : public ValueObject<bool> {
+public:
+    Bool(bool v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+        : ValueObject<bool>(v) {
+        SetKind(ObjectKind::Bool);
+    }
+
+    void Print(std::ostream& os, Context& context) override;
+};
+
+// Статистика размещения значений Mython, собираемая отдельно для каждого потока
+struct AllocationStats {
+    // Объекты, размещённые в куче функцией ObjectHolder::Own
+    size_t heap_objects = 0;
+    // Значения Number и Bool, сохранённые внутри ObjectHolder без выделения памяти
+    size_t inline_values = 0;
+};
+
+/*
+ * Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе.
+ * Значения Number и Bool хранятся непосредственно внутри ObjectHolder и копируются вместе с ним,
+ * остальные объекты размещаются в куче и разделяются всеми копиями ObjectHolder
+ */
 class ObjectHolder {
 public:
     // Создаёт пустое значение
     ObjectHolder() = default;
 
+    ObjectHolder(const ObjectHolder&) = default;
+    ObjectHolder& operator=(const ObjectHolder&) = default;
+
+    // После перемещения исходный ObjectHolder пуст
+    // Исходный ObjectHolder очищается через emplace: присваивание временного Data{} GCC при -O2
+    // ошибочно считает чтением неинициализированного значения Number или Bool
+    ObjectHolder(ObjectHolder&& other) noexcept
+        : data_(std::move(other.data_)) {
+        other.data_.emplace<EMPTY>();
+    }
+
+    ObjectHolder& operator=(ObjectHolder&& other) noexcept {
+        if (this != &other) {
+            data_ = std::move(other.data_);
+            other.data_.emplace<EMPTY>();
+        }
+        return *this;
+    }
+
+    // Возвращает true, если значения типа T хранятся внутри ObjectHolder, а не в куче
+    template <typename T>
+    static constexpr bool IS_INLINE = std::is_same_v<T, Number> || std::is_same_v<T, Bool>;
+
     // Возвращает ObjectHolder, владеющий объектом типа T
     // Тип T - конкретный класс-наследник Object.
-    // object копируется или перемещается в кучу
+    // object копируется или перемещается в кучу, а Number и Bool - внутрь ObjectHolder
     template <typename T>
     [[nodiscard]] static ObjectHolder Own(T&& object) {
-        return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+        using Type = std::decay_t<T>;
+        if constexpr (IS_INLINE<Type>) {
+            ++allocation_stats_.inline_values;
+            return ObjectHolder(Data(std::in_place_type<Type>, std::forward<T>(object)));
+        } else {
+            ++allocation_stats_.heap_objects;
+            auto* result = new Type(std::forward<T>(object));
+            if (!AdoptObject(*result)) {
+                if constexpr (std::is_base_of_v<ClassInstance, Type>) {
+                    TrackInstance(*result);
+                }
+            }
+            return ObjectHolder(Data(std::in_place_index<OWNED>, result));
+        }
     }
 
-    // Создаёт ObjectHolder, не владеющий объектом (аналог слабой ссылки)
+    // Создаёт ObjectHolder, ссылающийся на object без выделения памяти.
+    // Если объектом уже владеет другой ObjectHolder, ссылка становится владеющей и продлевает
+    // жизнь объекта, иначе (объект на стеке или статический) ссылка заимствованная
     [[nodiscard]] static ObjectHolder Share(Object& object);
     // Создаёт пустой ObjectHolder, соответствующий значению None
     [[nodiscard]] static ObjectHolder None();
@@ -51,47 +341,195 @@ public:
 
     Object* operator->() const;
 
-    [[nodiscard]] Object* Get() const;
+    // Указатель на хранящийся внутри ObjectHolder Number или Bool действителен,
+    // пока ObjectHolder не изменён и не разрушен
+    [[nodiscard]] Object* Get() const {
+        switch (data_.index()) {
+            case BORROWED:
+                return *std::get_if<BORROWED>(&data_);
+            case OWNED:
+                return std::get_if<OWNED>(&data_)->Get();
+            case NUMBER:
+                return const_cast<Number*>(std::get_if<NUMBER>(&data_));
+            case BOOL:
+                return const_cast<Bool*>(std::get_if<BOOL>(&data_));
+            default:
+                return nullptr;
+        }
+    }
 
     // Возвращает указатель на объект типа T либо nullptr, если внутри ObjectHolder не хранится
     // объект данного типа
     template <typename T>
     [[nodiscard]] T* TryAs() const {
-        return dynamic_cast<T*>(this->Get());
+        // Для значений, хранящихся внутри ObjectHolder, тип известен без dynamic_cast
+        if (auto* number = std::get_if<NUMBER>(&data_)) {
+            if constexpr (std::is_base_of_v<T, Number>) {
+                return const_cast<Number*>(number);
+            } else {
+                return nullptr;
+            }
+        }
+        if (auto* boolean = std::get_if<BOOL>(&data_)) {
+            if constexpr (std::is_base_of_v<T, Bool>) {
+                return const_cast<Bool*>(boolean);
+            } else {
+                return nullptr;
+            }
+        }
+        Object* object = Get();
+        if constexpr (KIND_OF<T> != ObjectKind::Other) {
+            return object != nullptr && object->GetKind() == KIND_OF<T> ? static_cast<T*>(object)
+                                                                        : nullptr;
+        } else {
+            return dynamic_cast<T*>(object);
+        }
+    }
+
+    // Возвращает вид хранящегося объекта либо ObjectKind::None для пустого ObjectHolder
+    [[nodiscard]] ObjectKind GetKind() const {
+        switch (data_.index()) {
+            case NUMBER:
+                return ObjectKind::Number;
+            case BOOL:
+                return ObjectKind::Bool;
+            default: {
+                const Object* object = Get();
+                return object != nullptr ? object->GetKind() : ObjectKind::None;
+            }
+        }
+    }
+
+    // Возвращает true, если ObjectHolder ссылается на объект, не владея им
+    [[nodiscard]] bool IsBorrowed() const {
+        return data_.index() == BORROWED;
     }
 
     // Возвращает true, если ObjectHolder не пуст
-    explicit operator bool() const;
+    explicit operator bool() const {
+        return Get() != nullptr;
+    }
+
+    // Возвращает статистику размещения значений в текущем потоке
+    [[nodiscard]] static AllocationStats& GetAllocationStats() {
+        return allocation_stats_;
+    }
 
 private:
-    explicit ObjectHolder(std::shared_ptr<Object> data);
+    // Владеющая ссылка на объект в куче, использующая счётчик ссылок из заголовка объекта
+    class Ref {
+    public:
+        explicit Ref(Object* object) noexcept
+            : object_(object) {
+            object_->header_.AddRef();
+        }
+
+        Ref(const Ref& other) noexcept
+            : Ref(other.object_) {
+        }
+
+        Ref(Ref&& other) noexcept
+            : object_(std::exchange(other.object_, nullptr)) {
+        }
+
+        Ref& operator=(const Ref& other) noexcept {
+            Ref copy(other);
+            std::swap(object_, copy.object_);
+            return *this;
+        }
+
+        Ref& operator=(Ref&& other) noexcept {
+            std::swap(object_, other.object_);
+            return *this;
+        }
+
+        ~Ref() {
+            if (object_ != nullptr && object_->header_.Release()) {
+                delete object_;
+            }
+        }
+
+        [[nodiscard]] Object* Get() const {
+            return object_;
+        }
+
+    private:
+        Object* object_;
+    };
+
+    // Порядок альтернатив соответствует константам EMPTY..BOOL
+    using Data = std::variant<std::monostate, Object*, Ref, Number, Bool>;
+    enum : size_t { EMPTY, BORROWED, OWNED, NUMBER, BOOL };
+
+    explicit ObjectHolder(Data data);
     void AssertIsValid() const;
 
-    std::shared_ptr<Object> data_;
+    Data data_;
+
+    static inline thread_local AllocationStats allocation_stats_;
 };
 
-// Объект-значение, хранящий значение типа T
-template <typename T>
-class ValueObject : public Object {
+// Кадр вызова метода: значения параметров и локальных переменных, пронумерованных при разборе
+using Frame = std::vector<ObjectHolder>;
+
+// Способ завершения исполнения инструкции
+enum class Completion {
+    Normal,    // управление переходит к следующей инструкции
+    Return,    // выполнена инструкция return, метод должен завершиться
+    Break,     // выполнена инструкция break, цикл должен завершиться
+    Continue,  // выполнена инструкция continue, цикл переходит к проверке условия
+};
+
+// Значение слота кадра, которому ещё ничего не присвоено. В отличие от None, его нельзя
+// получить в программе: чтение такого слота - ошибка, как и чтение отсутствующего в Closure имени
+class Unbound : public Object {
 public:
-    ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-        : value_(v) {
+    void Print(std::ostream& os, Context& context) override;
+};
+
+// Таблица символов, связывающая имя объекта с его значением. Имена хранятся в виде интернированных
+// символов, поэтому поиск по таблице не сравнивает строки.
+// Локальные переменные методов, для которых при разборе назначены номера слотов,
+// хранятся не в таблице, а в кадре и адресуются по номеру
+class Closure : public std::unordered_map<Symbol, ObjectHolder> {
+public:
+    using std::unordered_map<Symbol, ObjectHolder>::unordered_map;
+
+    // Возвращает слот кадра с номером index
+    ObjectHolder& Slot(size_t index) {
+        return frame_[index];
     }
 
-    void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
-        os << value_;
+    // Возвращает true, если слоту с номером index присвоено значение
+    [[nodiscard]] bool IsBound(size_t index) const {
+        return frame_[index].Get() != &unbound_;
     }
 
-    [[nodiscard]] const T& GetValue() const {
-        return value_;
+    // Выделяет кадр из frame_size слотов, которым ещё не присвоены значения
+    void AllocateFrame(size_t frame_size) {
+        frame_.assign(frame_size, ObjectHolder::Share(unbound_));
+    }
+
+    [[nodiscard]] const Frame& GetFrame() const {
+        return frame_;
+    }
+
+    // Способ завершения последней исполненной инструкции. Составные инструкции прекращают
+    // исполнение, если он отличен от Completion::Normal
+    [[nodiscard]] Completion GetCompletion() const {
+        return completion_;
+    }
+
+    void SetCompletion(Completion completion) {
+        completion_ = completion;
     }
 
 private:
-    T value_;
-};
+    static inline Unbound unbound_;
 
-// Таблица символов, связывающая имя объекта с его значением
-using Closure = std::unordered_map<std::string, ObjectHolder>;
+    Frame frame_;
+    Completion completion_ = Completion::Normal;
+};
 
 // Проверяет, содержится ли в object значение, приводимое к True
 // Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
@@ -101,32 +539,36 @@ bool IsTrue(const ObjectHolder& object);
 class Executable {
 public:
     virtual ~Executable() = default;
+
+    // Узлы, созданные при активной Arena::Scope, размещаются в арене, остальные - в куче
+    static void* operator new(size_t size);
+    static void operator delete(void* node) noexcept;
+
     // Выполняет действие над объектами внутри closure, используя context
     // Возвращает результирующее значение либо None
     virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
-};
 
-// Строковое значение
-using String = ValueObject<std::string>;
-// Числовое значение
-using Number = ValueObject<int>;
+    // Генерирует байт-код, который оставляет на стеке VM то же значение, что вернул бы Execute.
+    // Реализация по умолчанию делегирует исполнение узла обходу дерева
+    virtual void Compile(bytecode::Compiler& compiler);
 
-// Логическое значение
-class Bool : public ValueObject<bool> {
-public:
-    using ValueObject<bool>::ValueObject;
-
-    void Print(std::ostream& os, Context& context) override;
+    // Сворачивает константные подвыражения узла. Возвращает узел, которым нужно заменить данный,
+    // либо nullptr, если узел остаётся на месте. Реализация по умолчанию ничего не меняет
+    virtual std::unique_ptr<Executable> Fold();
 };
 
 // Метод класса
 struct Method {
     // Имя метода
-    std::string name;
+    Symbol name;
     // Имена формальных параметров метода
-    std::vector<std::string> formal_params;
+    std::vector<Symbol> formal_params;
     // Тело метода
     std::unique_ptr<Executable> body;
+    // Число слотов кадра, если локальные переменные метода пронумерованы при разборе.
+    // Слот 0 занимает self, слоты 1..N - формальные параметры.
+    // Значение 0 означает, что переменные метода хранятся в Closure по именам
+    size_t frame_size = 0;
 };
 
 // Класс
@@ -136,8 +578,9 @@ public:
     // Если parent равен nullptr, то создаётся базовый класс
     explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
 
-    // Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует
-    [[nodiscard]] const Method* GetMethod(const std::string& name) const;
+    // Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует.
+    // Поиск выполняется за O(1) по таблице методов независимо от глубины иерархии
+    [[nodiscard]] const Method* GetMethod(Symbol name) const;
 
     // Возвращает имя класса
     [[nodiscard]] const std::string& GetName() const;
@@ -145,10 +588,256 @@ public:
     // Выводит в os строку "Class <имя класса>", например "Class cat"
     void Print(std::ostream& os, Context& context) override;
 
+    // Возвращает текущее поколение методов классов. Оно меняется при каждом вызове
+    // InvalidateMethodCaches, после чего встроенные кэши вызовов сбрасываются
+    [[nodiscard]] static std::uint64_t GetMethodsEpoch();
+    // Должен вызываться после любого изменения methods_ или parent_ уже созданного класса
+    static void InvalidateMethodCaches();
+
+    // Перестраивает таблицу методов после изменения methods_ или parent_ и сбрасывает кэши вызовов.
+    // Наследники копируют таблицу родителя при создании, поэтому их таблицы нужно перестроить
+    // следом, начиная с ближайших к этому классу
+    void RebuildMethodTable();
+
     std::string name_;
     std::vector<Method> methods_;
     const Class* parent_;
 
+private:
+    static std::atomic<std::uint64_t> methods_epoch_;
+
+    // Методы класса вместе с унаследованными. Методы класса перекрывают одноимённые методы родителя
+    std::unordered_map<Symbol, const Method*> method_table_;
+};
+
+/*
+ * Встроенный кэш места вызова метода. Запоминает методы, найденные для классов получателей,
+ * и на повторных вызовах с тем же классом обходится без поиска по имени.
+ * Хранит до CAPACITY классов (полиморфный кэш), при переполнении вытесняет записи по кругу.
+ * Место вызова всегда передаёт одно и то же число аргументов, поэтому оно в ключ не входит
+ */
+class MethodCache {
+public:
+    static constexpr size_t CAPACITY = 4;
+
+    // Возвращает метод name класса cls, принимающий argument_count параметров, либо nullptr
+    [[nodiscard]] const Method* Lookup(const Class& cls, Symbol name, size_t argument_count);
+
+private:
+    struct Entry {
+        const Class* cls = nullptr;
+        const Method* method = nullptr;
+    };
+
+    std::array<Entry, CAPACITY> entries_;
+    size_t size_ = 0;
+    size_t next_victim_ = 0;
+    std::uint64_t epoch_ = 0;
+};
+
+/*
+ * Форма (скрытый класс) объекта - упорядоченный список имён его полей.
+ * Объекты, получившие одинаковые поля в одинаковом порядке, разделяют одну форму,
+ * а значения их полей хранятся в массиве по смещениям, которые задаёт форма.
+ * Формы образуют дерево переходов с корнем Shape::Empty() и живут до конца работы программы
+ */
+class Shape {
+public:
+    // Смещение, возвращаемое для отсутствующего поля
+    static constexpr size_t NO_FIELD = static_cast<size_t>(-1);
+
+    Shape(const Shape&) = delete;
+    Shape& operator=(const Shape&) = delete;
+
+    // Возвращает форму без полей
+    [[nodiscard]] static const Shape* Empty();
+
+    // Возвращает смещение поля name либо NO_FIELD
+    [[nodiscard]] size_t Find(Symbol name) const;
+
+    // Возвращает форму, получаемую добавлением поля name в конец. Поле должно отсутствовать
+    [[nodiscard]] const Shape* AddField(Symbol name) const;
+
+    [[nodiscard]] size_t GetFieldCount() const {
+        return names_.size();
+    }
+
+    [[nodiscard]] Symbol GetFieldName(size_t offset) const {
+        return names_[offset];
+    }
+
+private:
+    Shape() = default;
+
+    std::vector<Symbol> names_;
+    std::unordered_map<Symbol, size_t> offsets_;
+    // Переходы к формам с одним добавленным полем
+    mutable std::unordered_map<Symbol, std::unique_ptr<Shape>> transitions_;
+};
+
+/*
+ * Поля объекта: ссылка на форму и массив значений по её смещениям.
+ * Повторяет часть интерфейса std::unordered_map<Symbol, ObjectHolder>: operator[] добавляет
+ * отсутствующее поле, итераторы перебирают пары (имя, ссылка на значение) в порядке добавления
+ */
+class FieldTable {
+    template <typename Table, typename Value>
+    class Iterator {
+    public:
+        using value_type = std::pair<Symbol, Value&>;
+
+        Iterator(Table* table, size_t offset)
+            : table_(table)
+            , offset_(offset) {
+        }
+
+        value_type operator*() const {
+            return {table_->shape_->GetFieldName(offset_), table_->values_[offset_]};
+        }
+
+        // Позволяет писать it->first и it->second
+        struct Arrow {
+            value_type pair;
+            const value_type* operator->() const {
+                return &pair;
+            }
+        };
+
+        Arrow operator->() const {
+            return {**this};
+        }
+
+        Iterator& operator++() {
+            ++offset_;
+            return *this;
+        }
+
+        bool operator==(const Iterator& rhs) const {
+            return table_ == rhs.table_ && offset_ == rhs.offset_;
+        }
+
+        bool operator!=(const Iterator& rhs) const {
+            return !(*this == rhs);
+        }
+
+    private:
+        Table* table_;
+        size_t offset_;
+    };
+
+public:
+    using iterator = Iterator<FieldTable, ObjectHolder>;
+    using const_iterator = Iterator<const FieldTable, const ObjectHolder>;
+
+    // Возвращает значение поля name, добавляя поле со значением None при его отсутствии
+    ObjectHolder& operator[](Symbol name);
+
+    // Возвращает значение поля name либо выбрасывает std::out_of_range
+    [[nodiscard]] ObjectHolder& at(Symbol name);
+    [[nodiscard]] const ObjectHolder& at(Symbol name) const;
+
+    [[nodiscard]] iterator find(Symbol name);
+    [[nodiscard]] const_iterator find(Symbol name) const;
+    [[nodiscard]] size_t count(Symbol name) const;
+
+    [[nodiscard]] size_t size() const {
+        return values_.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return values_.empty();
+    }
+
+    iterator begin() {
+        return {this, 0};
+    }
+    iterator end() {
+        return {this, values_.size()};
+    }
+    const_iterator begin() const {
+        return {this, 0};
+    }
+    const_iterator end() const {
+        return {this, values_.size()};
+    }
+
+    [[nodiscard]] const Shape* GetShape() const {
+        return shape_;
+    }
+
+    // Возвращает значение по смещению offset текущей формы
+    [[nodiscard]] ObjectHolder& Slot(size_t offset) {
+        return values_[offset];
+    }
+
+    // Добавляет поле, переходя к форме shape, которая должна быть наследником текущей
+    // формы с одним новым полем. Возвращает значение добавленного поля
+    ObjectHolder& Append(const Shape* shape);
+
+    // Удаляет все поля, возвращаясь к форме без полей
+    void clear();
+
+private:
+    const Shape* shape_ = Shape::Empty();
+    std::vector<ObjectHolder> values_;
+};
+
+/*
+ * Встроенный кэш доступа к полю в конкретном месте программы. Запоминает форму последнего
+ * объекта и смещение поля в ней, а также последний переход формы при добавлении поля,
+ * так что для объектов одной формы доступ к полю сводится к индексации массива
+ */
+class FieldCache {
+public:
+    // Возвращает значение поля name объекта с полями fields, добавляя отсутствующее поле
+    ObjectHolder& Get(FieldTable& fields, Symbol name);
+
+private:
+    const Shape* shape_ = nullptr;
+    size_t offset_ = 0;
+    const Shape* transition_from_ = nullptr;
+    const Shape* transition_to_ = nullptr;
+};
+
+// Звено списка экземпляров класса, отслеживаемых сборщиком циклов.
+// Копия звена не входит в список, разрушение исключает звено из списка
+class CollectorLink {
+public:
+    CollectorLink() = default;
+
+    CollectorLink(const CollectorLink& /*other*/) noexcept {
+    }
+
+    CollectorLink& operator=(const CollectorLink& /*other*/) noexcept {
+        return *this;
+    }
+
+    ~CollectorLink() {
+        Unlink();
+    }
+
+    [[nodiscard]] bool IsLinked() const {
+        return next_ != nullptr;
+    }
+
+    // Исключает звено из списка, если оно в нём находится
+    void Unlink() noexcept {
+        if (next_ != nullptr) {
+            prev_->next_ = next_;
+            next_->prev_ = prev_;
+            prev_ = next_ = nullptr;
+        }
+    }
+
+private:
+    friend class CycleCollector;
+
+    CollectorLink* prev_ = nullptr;
+    CollectorLink* next_ = nullptr;
+    ClassInstance* owner_ = nullptr;
+    // Рабочие данные сборки: число ссылок извне отслеживаемых экземпляров и достижимость
+    std::uint32_t external_refs_ = 0;
+    bool reachable_ = false;
 };
 
 // Экземпляр класса
@@ -168,20 +857,32 @@ public:
      * Если ни сам класс, ни его родители не содержат метод method, метод выбрасывает исключение
      * runtime_error
      */
-    ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
+    ObjectHolder Call(Symbol method, const std::vector<ObjectHolder>& actual_args,
+                      Context& context);
+
+    // Вызывает у объекта уже найденный метод method его класса.
+    // Число actual_args должно совпадать с числом формальных параметров метода
+    ObjectHolder Call(const Method& method, const std::vector<ObjectHolder>& actual_args,
                       Context& context);
 
     // Возвращает true, если объект имеет метод method, принимающий argument_count параметров
-    [[nodiscard]] bool HasMethod(const std::string& method, size_t argument_count) const;
+    [[nodiscard]] bool HasMethod(Symbol method, size_t argument_count) const;
+
+    // Возвращает класс, экземпляром которого является объект
+    [[nodiscard]] const Class& GetClass() const;
 
-    // Возвращает ссылку на Closure, содержащий поля объекта
-    [[nodiscard]] Closure& Fields();
-    // Возвращает константную ссылку на Closure, содержащую поля объекта
-    [[nodiscard]] const Closure& Fields() const;
+    // Возвращает ссылку на таблицу полей объекта
+    [[nodiscard]] FieldTable& Fields();
+    // Возвращает константную ссылку на таблицу полей объекта
+    [[nodiscard]] const FieldTable& Fields() const;
 
 private:
+    friend class CycleCollector;
+    friend class GcHeap;
+
     const Class& class_;
-    Closure fields_;
+    FieldTable fields_;
+    CollectorLink collector_link_;
 };
 
 /*
@@ -212,6 +913,35 @@ bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& cont
 // Возвращает значение, противоположное Less(lhs, rhs, context)
 bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 
+/*
+ * Арифметические операции над объектами Mython, общие для обхода AST и виртуальной машины.
+ * Семантика совпадает с описанной для ast::Add, ast::Sub, ast::Mult и ast::Div.
+ * Для неподдерживаемых типов аргументов выбрасывается исключение runtime_error
+ */
+ObjectHolder Add(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+ObjectHolder Sub(const ObjectHolder& lhs, const ObjectHolder& rhs);
+ObjectHolder Mult(const ObjectHolder& lhs, const ObjectHolder& rhs);
+ObjectHolder Div(const ObjectHolder& lhs, const ObjectHolder& rhs);
+
+#ifndef MYTHON_SMALL_INT_MIN
+#define MYTHON_SMALL_INT_MIN (-5)
+#endif
+#ifndef MYTHON_SMALL_INT_MAX
+#define MYTHON_SMALL_INT_MAX 256
+#endif
+
+// Диапазон малых чисел, строковые представления которых создаются заранее, как в CPython.
+// Границы задаются при сборке макросами MYTHON_SMALL_INT_MIN и MYTHON_SMALL_INT_MAX
+inline constexpr int SMALL_INT_MIN = MYTHON_SMALL_INT_MIN;
+inline constexpr int SMALL_INT_MAX = MYTHON_SMALL_INT_MAX;
+
+/*
+ * Возвращает строковое представление object, как это делает функция str в Mython.
+ * Строки "True", "False", "None" и представления малых чисел - неизменяемые объекты,
+ * существующие до конца работы программы: результат ссылается на них без выделения памяти
+ */
+ObjectHolder Stringify(const ObjectHolder& object, Context& context);
+
 // Контекст-заглушка, применяется в тестах.
 // В этом контексте весь вывод перенаправляется в строковый поток вывода output
 struct DummyContext : Context {
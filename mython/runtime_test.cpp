@@ -1,3 +1,4 @@
+#include "collector.h"
 #include "runtime.h"
 #include "test_runner_p.h"
 
@@ -529,6 +530,469 @@ void TestClassInstance() {
     ASSERT_THROWS(instance.Call("missing_method"s, {}, ctx), runtime_error);
 }
 
+void TestMethodCache() {
+    auto make_method = [](const string& name, vector<Symbol> params, int result) {
+        auto body = [result](Closure& /*closure*/, Context& /*ctx*/) {
+            return ObjectHolder::Own(Number{result});
+        };
+        return Method{name, move(params), make_unique<TestMethodBody>(body)};
+    };
+
+    vector<Method> base_methods;
+    base_methods.push_back(make_method("f"s, {}, 1));
+    base_methods.push_back(make_method("g"s, {"x"s}, 2));
+    Class base{"Base"s, move(base_methods), nullptr};
+
+    vector<unique_ptr<Class>> derived;
+    for (int i = 0; i < static_cast<int>(MethodCache::CAPACITY) + 2; ++i) {
+        vector<Method> methods;
+        methods.push_back(make_method("f"s, {}, 10 + i));
+        derived.push_back(make_unique<Class>("Derived"s + to_string(i), move(methods), &base));
+    }
+
+    // Кэш принадлежит месту вызова, поэтому имя метода и число аргументов у него постоянны
+    ASSERT_EQUAL(MethodCache{}.Lookup(base, "f"s, 1), nullptr);
+    ASSERT_EQUAL(MethodCache{}.Lookup(base, "missing"s, 0), nullptr);
+
+    MethodCache cache;
+    ASSERT_EQUAL(cache.Lookup(base, "f"s, 0), base.GetMethod("f"s));
+    ASSERT_EQUAL(cache.Lookup(base, "f"s, 0), base.GetMethod("f"s));
+
+    // Полиморфное место вызова: классов больше, чем помещается в кэш
+    for (int round = 0; round < 2; ++round) {
+        for (const auto& cls : derived) {
+            ASSERT_EQUAL(cache.Lookup(*cls, "f"s, 0), cls->GetMethod("f"s));
+        }
+    }
+
+    MethodCache g_cache;
+    ASSERT_EQUAL(g_cache.Lookup(*derived[0], "g"s, 1), base.GetMethod("g"s));
+
+    // После изменения методов и сброса кэшей должен найтись новый метод
+    derived[0]->methods_.push_back(make_method("g"s, {"x"s}, 3));
+    derived[0]->RebuildMethodTable();
+    const Method* overridden = g_cache.Lookup(*derived[0], "g"s, 1);
+    ASSERT(overridden != nullptr);
+    ASSERT(overridden != base.GetMethod("g"s));
+    ASSERT_EQUAL(overridden, derived[0]->GetMethod("g"s));
+
+    ClassInstance instance{*derived[0]};
+    DummyContext ctx;
+    ObjectHolder result = instance.Call(*overridden, {ObjectHolder::Own(Number{0})}, ctx);
+    ASSERT_EQUAL(result.TryAs<Number>()->GetValue(), 3);
+}
+
+void TestMethodTableInheritance() {
+    auto make_method = [](const string& name, int result) {
+        auto body = [result](Closure& /*closure*/, Context& /*ctx*/) {
+            return ObjectHolder::Own(Number{result});
+        };
+        return Method{name, {}, make_unique<TestMethodBody>(body)};
+    };
+
+    // Глубокая иерархия: каждый уровень i добавляет метод level<i> и перекрывает метод top
+    vector<unique_ptr<Class>> hierarchy;
+    const int depth = 50;
+    for (int i = 0; i < depth; ++i) {
+        vector<Method> methods;
+        methods.push_back(make_method("level"s + to_string(i), i));
+        methods.push_back(make_method("top"s, i));
+        methods.push_back(make_method("top"s, -1));
+        const Class* parent = hierarchy.empty() ? nullptr : hierarchy.back().get();
+        hierarchy.push_back(make_unique<Class>("C"s + to_string(i), move(methods), parent));
+    }
+
+    const Class& leaf = *hierarchy.back();
+    DummyContext ctx;
+    Closure closure;
+    for (int i = 0; i < depth; ++i) {
+        const Method* method = leaf.GetMethod("level"s + to_string(i));
+        ASSERT(method != nullptr);
+        ASSERT_EQUAL(method, hierarchy[i]->GetMethod("level"s + to_string(i)));
+        ASSERT_EQUAL(method->body->Execute(closure, ctx).TryAs<Number>()->GetValue(), i);
+    }
+    const Method* top = leaf.GetMethod("top"s);
+    ASSERT(top != nullptr);
+    ASSERT_EQUAL(top, &leaf.methods_[1]);
+    ASSERT_EQUAL(hierarchy.front()->GetMethod("level1"s), nullptr);
+    ASSERT_EQUAL(leaf.GetMethod("missing"s), nullptr);
+}
+
+void TestSymbols() {
+    const size_t count = GetSymbolCount();
+    const Symbol a = "symbol_test_name"s;
+    const Symbol b = "symbol_test_name"sv;
+    const Symbol c = "symbol_test_name";
+    ASSERT_EQUAL(GetSymbolCount(), count + 1);
+    ASSERT(a == b && b == c);
+    ASSERT_EQUAL(a.GetId(), c.GetId());
+    ASSERT_EQUAL(a.GetName(), "symbol_test_name"s);
+    ASSERT_EQUAL(&a.GetName(), &c.GetName());
+
+    const Symbol other = "symbol_test_other"s;
+    ASSERT(a != other);
+    ASSERT_EQUAL(Symbol{}.GetName(), ""s);
+    ASSERT_EQUAL(Symbol{}, Symbol(""s));
+
+    ostringstream out;
+    out << a;
+    ASSERT_EQUAL(out.str(), "symbol_test_name"s);
+
+    // Closure ищет значения по символам, но принимает и строки
+    Closure closure{{"symbol_test_name"s, ObjectHolder::Own(Number{1})}};
+    ASSERT_EQUAL(closure.count(c), 1U);
+    ASSERT_EQUAL(closure.at("symbol_test_name"s).TryAs<Number>()->GetValue(), 1);
+}
+
+void TestShapes() {
+    Class cls{"Point"s, {}, nullptr};
+    ClassInstance a{cls};
+    ClassInstance b{cls};
+    ClassInstance c{cls};
+
+    a.Fields()["x"s] = ObjectHolder::Own(Number{1});
+    a.Fields()["y"s] = ObjectHolder::Own(Number{2});
+    b.Fields()["x"s] = ObjectHolder::Own(Number{3});
+    b.Fields()["y"s] = ObjectHolder::Own(Number{4});
+    c.Fields()["y"s] = ObjectHolder::Own(Number{5});
+    c.Fields()["x"s] = ObjectHolder::Own(Number{6});
+
+    // Одинаковый порядок добавления полей - одна форма
+    ASSERT_EQUAL(a.Fields().GetShape(), b.Fields().GetShape());
+    ASSERT(a.Fields().GetShape() != c.Fields().GetShape());
+    ASSERT_EQUAL(a.Fields().size(), c.Fields().size());
+
+    const Shape* shape = a.Fields().GetShape();
+    const size_t x_offset = shape->Find("x"s);
+    ASSERT(x_offset != Shape::NO_FIELD);
+    ASSERT_EQUAL(shape->GetFieldName(x_offset), Symbol("x"s));
+    ASSERT_EQUAL(shape->Find("z"s), Shape::NO_FIELD);
+
+    ASSERT_EQUAL(a.Fields().count("y"s), 1U);
+    ASSERT_EQUAL(a.Fields().count("z"s), 0U);
+    ASSERT(a.Fields().find("z"s) == a.Fields().end());
+    ASSERT_EQUAL(b.Fields().find("y"s)->second.TryAs<Number>()->GetValue(), 4);
+    ASSERT_THROWS(static_cast<void>(a.Fields().at("z"s)), out_of_range);
+
+    // Поля перебираются в порядке добавления
+    vector<Symbol> names;
+    for (const auto& field : c.Fields()) {
+        names.push_back(field.first);
+    }
+    ASSERT_EQUAL(names.size(), 2U);
+    ASSERT_EQUAL(names[0], Symbol("y"s));
+    ASSERT_EQUAL(names[1], Symbol("x"s));
+
+    // Кэш поля работает для объектов разных форм и запоминает добавление поля
+    FieldCache cache;
+    ASSERT_EQUAL(cache.Get(a.Fields(), "x"s).TryAs<Number>()->GetValue(), 1);
+    ASSERT_EQUAL(cache.Get(b.Fields(), "x"s).TryAs<Number>()->GetValue(), 3);
+    ASSERT_EQUAL(cache.Get(c.Fields(), "x"s).TryAs<Number>()->GetValue(), 6);
+
+    FieldCache add_cache;
+    add_cache.Get(a.Fields(), "z"s) = ObjectHolder::Own(Number{7});
+    add_cache.Get(b.Fields(), "z"s) = ObjectHolder::Own(Number{8});
+    ASSERT_EQUAL(a.Fields().GetShape(), b.Fields().GetShape());
+    ASSERT_EQUAL(b.Fields().at("z"s).TryAs<Number>()->GetValue(), 8);
+    ASSERT_EQUAL(a.Fields().at("z"s).TryAs<Number>()->GetValue(), 7);
+}
+
+void TestInlineValues() {
+    static_assert(sizeof(ObjectHolder) <= 3 * sizeof(void*));
+
+    AllocationStats& stats = ObjectHolder::GetAllocationStats();
+    const AllocationStats before = stats;
+
+    auto number = ObjectHolder::Own(Number{42});
+    auto boolean = ObjectHolder::Own(Bool{true});
+    ASSERT_EQUAL(stats.heap_objects, before.heap_objects);
+    ASSERT_EQUAL(stats.inline_values, before.inline_values + 2);
+
+    ASSERT(number.TryAs<Number>() != nullptr && number.TryAs<Number>()->GetValue() == 42);
+    ASSERT(number.TryAs<ValueObject<int>>() == number.TryAs<Number>());
+    ASSERT(number.TryAs<Object>() == number.Get());
+    ASSERT(number.TryAs<Bool>() == nullptr);
+    ASSERT(number.TryAs<String>() == nullptr);
+    ASSERT(number.TryAs<ClassInstance>() == nullptr);
+    ASSERT(boolean.TryAs<Bool>() != nullptr && boolean.TryAs<Bool>()->GetValue());
+    ASSERT(boolean.TryAs<ValueObject<bool>>() != nullptr);
+    ASSERT(boolean.TryAs<Number>() == nullptr);
+
+    // Копия хранит собственное значение
+    ObjectHolder copy = number;
+    ASSERT(copy.Get() != number.Get());
+    ASSERT_EQUAL(copy.TryAs<Number>()->GetValue(), 42);
+
+    ObjectHolder moved = std::move(copy);
+    ASSERT(!copy);  // NOLINT
+    ASSERT_EQUAL(moved.TryAs<Number>()->GetValue(), 42);
+
+    // Арифметика и сравнения чисел не обращаются к куче
+    DummyContext context;
+    const size_t heap_objects = stats.heap_objects;
+    ObjectHolder sum = ObjectHolder::Own(Number{0});
+    for (int i = 0; i < 100; ++i) {
+        sum = Add(sum, Mult(ObjectHolder::Own(Number{i}), ObjectHolder::Own(Number{2})), context);
+    }
+    ASSERT_EQUAL(sum.TryAs<Number>()->GetValue(), 9900);
+    ASSERT(Less(number, sum, context));
+    ASSERT_EQUAL(stats.heap_objects, heap_objects);
+
+    // Строки по-прежнему размещаются в куче
+    auto str = ObjectHolder::Own(String{"text"s});
+    ASSERT_EQUAL(stats.heap_objects, heap_objects + 1);
+    ASSERT(str.TryAs<String>() != nullptr);
+}
+
+void TestObjectKinds() {
+    Class cls{"Test"s, {}, nullptr};
+    ClassInstance instance{cls};
+    Logger logger;
+
+    ASSERT(ObjectHolder::None().GetKind() == ObjectKind::None);
+    ASSERT(ObjectHolder::Own(Number{1}).GetKind() == ObjectKind::Number);
+    ASSERT(ObjectHolder::Own(Bool{false}).GetKind() == ObjectKind::Bool);
+    ASSERT(ObjectHolder::Own(String{"s"s}).GetKind() == ObjectKind::String);
+    ASSERT(ObjectHolder::Share(cls).GetKind() == ObjectKind::Class);
+    ASSERT(ObjectHolder::Share(instance).GetKind() == ObjectKind::ClassInstance);
+    ASSERT(ObjectHolder::Share(logger).GetKind() == ObjectKind::Other);
+
+    // Вид определяется и для объектов, не хранящихся внутри ObjectHolder
+    Number number{2};
+    Bool boolean{true};
+    ASSERT(ObjectHolder::Share(number).GetKind() == ObjectKind::Number);
+    ASSERT(ObjectHolder::Share(boolean).GetKind() == ObjectKind::Bool);
+    ASSERT_EQUAL(ObjectHolder::Share(boolean).TryAs<Bool>(), &boolean);
+    ASSERT_EQUAL(ObjectHolder::Share(number).TryAs<Bool>(), nullptr);
+
+    // ValueObject<bool> не является Bool
+    ValueObject<bool> raw_bool{true};
+    ASSERT(ObjectHolder::Share(raw_bool).GetKind() == ObjectKind::Other);
+    ASSERT_EQUAL(ObjectHolder::Share(raw_bool).TryAs<Bool>(), nullptr);
+    ASSERT_EQUAL(ObjectHolder::Share(raw_bool).TryAs<ValueObject<bool>>(), &raw_bool);
+
+    ASSERT_EQUAL(ObjectHolder::Share(cls).TryAs<Class>(), &cls);
+    ASSERT_EQUAL(ObjectHolder::Share(cls).TryAs<ClassInstance>(), nullptr);
+    ASSERT_EQUAL(ObjectHolder::Share(instance).TryAs<ClassInstance>(), &instance);
+    ASSERT_EQUAL(ObjectHolder::Share(logger).TryAs<Logger>(), &logger);
+    ASSERT_EQUAL(ObjectHolder::Share(logger).TryAs<String>(), nullptr);
+
+    ASSERT(KindPair(ObjectKind::Number, ObjectKind::String)
+           != KindPair(ObjectKind::String, ObjectKind::Number));
+}
+
+void TestImmortalStrings() {
+    DummyContext context;
+    AllocationStats& stats = ObjectHolder::GetAllocationStats();
+    const size_t heap_objects = stats.heap_objects;
+
+    auto as_string = [](const ObjectHolder& object) {
+        return object.TryAs<String>()->GetValue();
+    };
+
+    const ObjectHolder zero = Stringify(ObjectHolder::Own(Number{0}), context);
+    const ObjectHolder min = Stringify(ObjectHolder::Own(Number{SMALL_INT_MIN}), context);
+    const ObjectHolder max = Stringify(ObjectHolder::Own(Number{SMALL_INT_MAX}), context);
+    const ObjectHolder yes = Stringify(ObjectHolder::Own(Bool{true}), context);
+    const ObjectHolder no = Stringify(ObjectHolder::Own(Bool{false}), context);
+    const ObjectHolder none = Stringify(ObjectHolder::None(), context);
+    ASSERT_EQUAL(stats.heap_objects, heap_objects);
+
+    ASSERT_EQUAL(as_string(zero), "0"s);
+    ASSERT_EQUAL(as_string(min), to_string(SMALL_INT_MIN));
+    ASSERT_EQUAL(as_string(max), to_string(SMALL_INT_MAX));
+    ASSERT_EQUAL(as_string(yes), "True"s);
+    ASSERT_EQUAL(as_string(no), "False"s);
+    ASSERT_EQUAL(as_string(none), "None"s);
+
+    // Повторные вызовы возвращают те же объекты
+    ASSERT_EQUAL(Stringify(ObjectHolder::Own(Number{0}), context).Get(), zero.Get());
+    ASSERT_EQUAL(Stringify(ObjectHolder::Own(Bool{true}), context).Get(), yes.Get());
+
+    // Числа вне диапазона по-прежнему размещаются в куче
+    const ObjectHolder big = Stringify(ObjectHolder::Own(Number{SMALL_INT_MAX + 1}), context);
+    ASSERT_EQUAL(as_string(big), to_string(SMALL_INT_MAX + 1));
+    ASSERT_EQUAL(stats.heap_objects, heap_objects + 1);
+}
+
+void TestRefCounting() {
+    // Счётчик ссылок упакован в заголовок вместе с видом объекта и не увеличивает Number
+    static_assert(sizeof(Number) == 2 * sizeof(void*));
+
+    ASSERT_EQUAL(Logger::instance_count, 0);
+    {
+        auto one = ObjectHolder::Own(Logger(5));
+        ASSERT_EQUAL(one->GetRefCount(), 1U);
+        {
+            ObjectHolder two = one;
+            ASSERT_EQUAL(one->GetRefCount(), 2U);
+            ObjectHolder three;
+            three = two;
+            ASSERT_EQUAL(one->GetRefCount(), 3U);
+            three = three;  // NOLINT
+            ASSERT_EQUAL(one->GetRefCount(), 3U);
+        }
+        ASSERT_EQUAL(one->GetRefCount(), 1U);
+
+        // Ссылка на объект, которым владеет ObjectHolder, тоже владеющая
+        {
+            auto shared = ObjectHolder::Share(*one);
+            ASSERT(!shared.IsBorrowed());
+            ASSERT_EQUAL(one->GetRefCount(), 2U);
+        }
+        ASSERT_EQUAL(one->GetRefCount(), 1U);
+
+        // Заимствованная ссылка не меняет счётчик
+        Logger local(6);
+        auto borrowed = ObjectHolder::Share(local);
+        ASSERT(borrowed.IsBorrowed());
+        ASSERT_EQUAL(local.GetRefCount(), 0U);
+
+        // Копия объекта получает собственный счётчик
+        auto copy = ObjectHolder::Own(Logger(*one.TryAs<Logger>()));
+        ASSERT_EQUAL(copy->GetRefCount(), 1U);
+        ASSERT_EQUAL(Logger::instance_count, 3);
+
+        ObjectHolder moved = std::move(one);
+        ASSERT_EQUAL(moved->GetRefCount(), 1U);
+        ASSERT_EQUAL(Logger::instance_count, 3);
+    }
+    ASSERT_EQUAL(Logger::instance_count, 0);
+
+    auto str = ObjectHolder::Own(String{"value"s});
+    ASSERT(str.GetKind() == ObjectKind::String);
+    ObjectHolder str_copy = str;
+    ASSERT_EQUAL(str->GetRefCount(), 2U);
+    ASSERT(str_copy.GetKind() == ObjectKind::String);
+}
+
+void TestObjectPools() {
+    static_assert(sizeof(String) <= object_pool::MAX_POOLED_SIZE);
+
+    PoolStats& stats = object_pool::GetStats();
+    const PoolStats before = stats;
+
+    const Object* first = nullptr;
+    {
+        auto str = ObjectHolder::Own(String{"pooled"s});
+        first = str.Get();
+        ASSERT(stats.bytes >= before.bytes + sizeof(String));
+        ASSERT(stats.peak_bytes >= stats.bytes);
+    }
+    ASSERT_EQUAL(stats.bytes, before.bytes);
+
+    // Блок удалённого объекта того же класса размера используется повторно
+    const size_t hits = stats.hits;
+    auto again = ObjectHolder::Own(String{"again"s});
+    ASSERT_EQUAL(again.Get(), first);
+    ASSERT_EQUAL(stats.hits, hits + 1);
+
+    // Объекты одного класса размера занимают разные блоки
+    vector<ObjectHolder> strings;
+    for (int i = 0; i < 100; ++i) {
+        strings.push_back(ObjectHolder::Own(String{to_string(i)}));
+    }
+    ASSERT(strings.front().Get() != strings.back().Get());
+    ASSERT_EQUAL(strings[42].TryAs<String>()->GetValue(), "42"s);
+    const size_t peak = stats.peak_bytes;
+    strings.clear();
+    ASSERT_EQUAL(stats.peak_bytes, peak);
+    ASSERT(stats.bytes < peak);
+}
+
+void TestCycleCollector() {
+    CycleCollector& collector = CycleCollector::Instance();
+    collector.Collect();
+    const size_t tracked = collector.GetTrackedCount();
+    const CollectorStats before = collector.GetStats();
+
+    Class cls{"Node"s, {}, nullptr};
+    ASSERT_EQUAL(Logger::instance_count, 0);
+    {
+        auto a = ObjectHolder::Own(ClassInstance{cls});
+        auto b = ObjectHolder::Own(ClassInstance{cls});
+        auto c = ObjectHolder::Own(ClassInstance{cls});
+        a.TryAs<ClassInstance>()->Fields()["peer"s] = b;
+        a.TryAs<ClassInstance>()->Fields()["payload"s] = ObjectHolder::Own(Logger(1));
+        b.TryAs<ClassInstance>()->Fields()["peer"s] = a;
+        // Экземпляр, ссылающийся сам на себя
+        c.TryAs<ClassInstance>()->Fields()["me"s] = c;
+        ASSERT_EQUAL(collector.GetTrackedCount(), tracked + 3);
+
+        // Пока на циклы есть ссылки извне, сборка их не трогает
+        ASSERT_EQUAL(collector.Collect(), 0U);
+        ASSERT_EQUAL(Logger::instance_count, 1);
+    }
+    // Счётчик ссылок не освобождает циклы
+    ASSERT_EQUAL(collector.GetTrackedCount(), tracked + 3);
+    ASSERT_EQUAL(Logger::instance_count, 1);
+
+    ASSERT_EQUAL(collector.Collect(), 3U);
+    ASSERT_EQUAL(collector.GetTrackedCount(), tracked);
+    ASSERT_EQUAL(Logger::instance_count, 0);
+
+    const CollectorStats& stats = collector.GetStats();
+    ASSERT_EQUAL(stats.collections, before.collections + 2);
+    ASSERT_EQUAL(stats.freed, before.freed + 3);
+    ASSERT(stats.scanned >= before.scanned + 6);
+    ASSERT(stats.total_pause >= before.total_pause + stats.last_pause);
+
+    // Экземпляр, достижимый только из живого экземпляра, тоже остаётся в живых
+    auto root = ObjectHolder::Own(ClassInstance{cls});
+    {
+        auto x = ObjectHolder::Own(ClassInstance{cls});
+        auto y = ObjectHolder::Own(ClassInstance{cls});
+        x.TryAs<ClassInstance>()->Fields()["peer"s] = y;
+        y.TryAs<ClassInstance>()->Fields()["peer"s] = x;
+        root.TryAs<ClassInstance>()->Fields()["child"s] = x;
+    }
+    ASSERT_EQUAL(collector.Collect(), 0U);
+    root.TryAs<ClassInstance>()->Fields().clear();
+    ASSERT_EQUAL(collector.Collect(), 2U);
+
+    // Автоматическая сборка ограничивает число накопившихся циклов
+    const size_t threshold = collector.GetThreshold();
+    collector.SetThreshold(10);
+    for (int i = 0; i < 100; ++i) {
+        auto node = ObjectHolder::Own(ClassInstance{cls});
+        node.TryAs<ClassInstance>()->Fields()["me"s] = node;
+    }
+    ASSERT(collector.GetTrackedCount() <= tracked + 1 + 10);
+    collector.SetThreshold(threshold);
+    root = ObjectHolder::None();
+    collector.Collect();
+    ASSERT_EQUAL(collector.GetTrackedCount(), tracked);
+}
+
+void TestSelfReference() {
+    DummyContext context;
+    vector<Method> methods;
+    methods.push_back({"get_self"s, {}, make_unique<TestMethodBody>([](Closure& closure, Context&) {
+                           return closure.at("self"s);
+                       })});
+    Class cls{"Node"s, std::move(methods), nullptr};
+
+    // self не хранится среди полей экземпляра
+    ClassInstance local{cls};
+    ASSERT(local.Fields().empty());
+
+    // На объект вне кучи можно сослаться только без владения
+    auto local_self = local.Call("get_self"s, {}, context);
+    ASSERT(local_self.IsBorrowed());
+    ASSERT_EQUAL(local_self.Get(), &local);
+
+    // self объекта в куче продлевает его жизнь после уничтожения исходного ObjectHolder
+    auto instance = ObjectHolder::Own(ClassInstance{cls});
+    auto* raw = instance.TryAs<ClassInstance>();
+    auto self = raw->Call("get_self"s, {}, context);
+    ASSERT(!self.IsBorrowed());
+    ASSERT_EQUAL(raw->GetRefCount(), 2U);
+    instance = ObjectHolder::None();
+    ASSERT_EQUAL(raw->GetRefCount(), 1U);
+    ASSERT_EQUAL(self.TryAs<ClassInstance>(), raw);
+    ASSERT(self.TryAs<ClassInstance>()->HasMethod("get_self"s, 0U));
+}
+
 }  // namespace
 
 void RunObjectsTests(TestRunner& tr) {
@@ -540,6 +1004,11 @@ void RunObjectsTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestComparison);
     RUN_TEST(tr, runtime::TestClass);
     RUN_TEST(tr, runtime::TestClassInstance);
+    RUN_TEST(tr, runtime::TestMethodCache);
+    RUN_TEST(tr, runtime::TestMethodTableInheritance);
+    RUN_TEST(tr, runtime::TestSymbols);
+    RUN_TEST(tr, runtime::TestShapes);
+    RUN_TEST(tr, runtime::TestObjectKinds);
 }
 
 void RunObjectHolderTests(TestRunner& tr) {
@@ -547,6 +1016,12 @@ void RunObjectHolderTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestOwning);
     RUN_TEST(tr, runtime::TestMove);
     RUN_TEST(tr, runtime::TestNullptr);
+    RUN_TEST(tr, runtime::TestInlineValues);
+    RUN_TEST(tr, runtime::TestImmortalStrings);
+    RUN_TEST(tr, runtime::TestRefCounting);
+    RUN_TEST(tr, runtime::TestSelfReference);
+    RUN_TEST(tr, runtime::TestObjectPools);
+    RUN_TEST(tr, runtime::TestCycleCollector);
 }
 
 }  // namespace runtime
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "scan.h"
+
+#include <initializer_list>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define MYTHON_HAS_SSE2 1
+// AVX2 включается только для функций, помеченных MYTHON_TARGET_AVX2, и используется,
+// если его поддерживает процессор, на котором запущен интерпретатор
+#define MYTHON_HAS_AVX2 1
+#define MYTHON_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MYTHON_HAS_SSE2 0
+#define MYTHON_HAS_AVX2 0
+#endif
+
+namespace parse::scan {
+
+namespace {
+
+bool IsIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+const char* SkipSpacesScalar(const char* p, const char* end) {
+    while (p != end && *p == ' ') {
+        ++p;
+    }
+    return p;
+}
+
+const char* SkipIdentifierScalar(const char* p, const char* end) {
+    while (p != end && IsIdentifierChar(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* FindLineEndScalar(const char* p, const char* end) {
+    while (p != end && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+const char* FindQuoteOrEscapeScalar(const char* p, const char* end, char quote) {
+    while (p != end && *p != quote && *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+const Scanner SCALAR_SCANNER{Level::Scalar, SkipSpacesScalar, SkipIdentifierScalar,
+                             FindLineEndScalar, FindQuoteOrEscapeScalar};
+
+#if MYTHON_HAS_SSE2
+
+constexpr int SSE2_BLOCK = 16;
+
+__m128i LoadSse2(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// Биты маски соответствуют символам блока, на которых лексема заканчивается
+unsigned StopMaskSse2(__m128i continues) {
+    return ~static_cast<unsigned>(_mm_movemask_epi8(continues)) & 0xFFFFu;
+}
+
+unsigned MatchMaskSse2(__m128i matches) {
+    return static_cast<unsigned>(_mm_movemask_epi8(matches));
+}
+
+const char* SkipSpacesSse2(const char* p, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; end - p >= SSE2_BLOCK; p += SSE2_BLOCK) {
+        const unsigned mask = StopMaskSse2(_mm_cmpeq_epi8(LoadSse2(p), space));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SkipSpacesScalar(p, end);
+}
+
+const char* SkipIdentifierSse2(const char* p, const char* end) {
+    // Символы вне ASCII отрицательны и не попадают ни в один из диапазонов
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i before_a = _mm_set1_epi8('a' - 1);
+    const __m128i after_z = _mm_set1_epi8('z' + 1);
+    const __m128i before_0 = _mm_set1_epi8('0' - 1);
+    const __m128i after_9 = _mm_set1_epi8('9' + 1);
+    const __m128i underscore = _mm_set1_epi8('_');
+    for (; end - p >= SSE2_BLOCK; p += SSE2_BLOCK) {
+        const __m128i block = LoadSse2(p);
+        // Установка бита 0x20 переводит заглавные буквы в строчные
+        const __m128i lower = _mm_or_si128(block, case_bit);
+        const __m128i alpha
+            = _mm_and_si128(_mm_cmpgt_epi8(lower, before_a), _mm_cmplt_epi8(lower, after_z));
+        const __m128i digit
+            = _mm_and_si128(_mm_cmpgt_epi8(block, before_0), _mm_cmplt_epi8(block, after_9));
+        const __m128i ident
+            = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(block, underscore));
+        const unsigned mask = StopMaskSse2(ident);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SkipIdentifierScalar(p, end);
+}
+
+const char* FindLineEndSse2(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= SSE2_BLOCK; p += SSE2_BLOCK) {
+        const unsigned mask = MatchMaskSse2(_mm_cmpeq_epi8(LoadSse2(p), newline));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindLineEndScalar(p, end);
+}
+
+const char* FindQuoteOrEscapeSse2(const char* p, const char* end, char quote) {
+    const __m128i quote_char = _mm_set1_epi8(quote);
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; end - p >= SSE2_BLOCK; p += SSE2_BLOCK) {
+        const __m128i block = LoadSse2(p);
+        const unsigned mask = MatchMaskSse2(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote_char), _mm_cmpeq_epi8(block, backslash)));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindQuoteOrEscapeScalar(p, end, quote);
+}
+
+const Scanner SSE2_SCANNER{Level::Sse2, SkipSpacesSse2, SkipIdentifierSse2, FindLineEndSse2,
+                           FindQuoteOrEscapeSse2};
+
+#endif
+
+#if MYTHON_HAS_AVX2
+
+constexpr int AVX2_BLOCK = 32;
+
+MYTHON_TARGET_AVX2 __m256i LoadAvx2(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+MYTHON_TARGET_AVX2 unsigned StopMaskAvx2(__m256i continues) {
+    return ~static_cast<unsigned>(_mm256_movemask_epi8(continues));
+}
+
+MYTHON_TARGET_AVX2 unsigned MatchMaskAvx2(__m256i matches) {
+    return static_cast<unsigned>(_mm256_movemask_epi8(matches));
+}
+
+MYTHON_TARGET_AVX2 const char* SkipSpacesAvx2(const char* p, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    for (; end - p >= AVX2_BLOCK; p += AVX2_BLOCK) {
+        const unsigned mask = StopMaskAvx2(_mm256_cmpeq_epi8(LoadAvx2(p), space));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SkipSpacesScalar(p, end);
+}
+
+MYTHON_TARGET_AVX2 const char* SkipIdentifierAvx2(const char* p, const char* end) {
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i before_a = _mm256_set1_epi8('a' - 1);
+    const __m256i after_z = _mm256_set1_epi8('z' + 1);
+    const __m256i before_0 = _mm256_set1_epi8('0' - 1);
+    const __m256i after_9 = _mm256_set1_epi8('9' + 1);
+    const __m256i underscore = _mm256_set1_epi8('_');
+    for (; end - p >= AVX2_BLOCK; p += AVX2_BLOCK) {
+        const __m256i block = LoadAvx2(p);
+        const __m256i lower = _mm256_or_si256(block, case_bit);
+        const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, before_a),
+                                               _mm256_cmpgt_epi8(after_z, lower));
+        const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, before_0),
+                                               _mm256_cmpgt_epi8(after_9, block));
+        const __m256i ident
+            = _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(block, underscore));
+        const unsigned mask = StopMaskAvx2(ident);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SkipIdentifierScalar(p, end);
+}
+
+MYTHON_TARGET_AVX2 const char* FindLineEndAvx2(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; end - p >= AVX2_BLOCK; p += AVX2_BLOCK) {
+        const unsigned mask = MatchMaskAvx2(_mm256_cmpeq_epi8(LoadAvx2(p), newline));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindLineEndScalar(p, end);
+}
+
+MYTHON_TARGET_AVX2 const char* FindQuoteOrEscapeAvx2(const char* p, const char* end, char quote) {
+    const __m256i quote_char = _mm256_set1_epi8(quote);
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    for (; end - p >= AVX2_BLOCK; p += AVX2_BLOCK) {
+        const __m256i block = LoadAvx2(p);
+        const unsigned mask = MatchMaskAvx2(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote_char),
+                                                            _mm256_cmpeq_epi8(block, backslash)));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindQuoteOrEscapeScalar(p, end, quote);
+}
+
+const Scanner AVX2_SCANNER{Level::Avx2, SkipSpacesAvx2, SkipIdentifierAvx2, FindLineEndAvx2,
+                           FindQuoteOrEscapeAvx2};
+
+#endif
+
+}  // namespace
+
+const Scanner* GetScanner(Level level) {
+    switch (level) {
+        case Level::Scalar:
+            return &SCALAR_SCANNER;
+        case Level::Sse2:
+#if MYTHON_HAS_SSE2
+            return &SSE2_SCANNER;
+#else
+            return nullptr;
+#endif
+        case Level::Avx2:
+#if MYTHON_HAS_AVX2
+            return __builtin_cpu_supports("avx2") ? &AVX2_SCANNER : nullptr;
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const Scanner& GetScanner() {
+    static const Scanner& best = [] () -> const Scanner& {
+        for (const Level level : {Level::Avx2, Level::Sse2}) {
+            if (const Scanner* scanner = GetScanner(level)) {
+                return *scanner;
+            }
+        }
+        return SCALAR_SCANNER;
+    }();
+    return best;
+}
+
+}  // namespace parse::scan
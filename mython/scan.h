@@ -0,0 +1,38 @@
+#pragma once
+
+namespace parse::scan {
+
+// Набор команд, которым выполняется поиск границ лексем
+enum class Level {
+    Scalar,  // по одному символу
+    Sse2,    // по 16 символов
+    Avx2,    // по 32 символа
+};
+
+/*
+ * Функции поиска границ лексем в тексте [begin, end). Каждая функция возвращает указатель
+ * на первый символ, на котором лексема заканчивается, либо end.
+ * Векторные реализации классифицируют сразу блок символов и читают только полные блоки
+ * внутри [begin, end), а остаток текста разбирают по одному символу
+ */
+struct Scanner {
+    Level level;
+    // Пропускает пробелы
+    const char* (*skip_spaces)(const char* begin, const char* end);
+    // Пропускает символы [A-Za-z0-9_]
+    const char* (*skip_identifier)(const char* begin, const char* end);
+    // Ищет конец строки '\n'
+    const char* (*find_line_end)(const char* begin, const char* end);
+    // Ищет закрывающую кавычку quote или начало escape-последовательности '\\'
+    const char* (*find_quote_or_escape)(const char* begin, const char* end, char quote);
+};
+
+// Возвращает реализацию с самым широким набором команд, который поддерживает процессор.
+// Выбор делается один раз при первом вызове
+[[nodiscard]] const Scanner& GetScanner();
+
+// Возвращает реализацию для набора команд level либо nullptr, если процессор
+// или компилятор его не поддерживают
+[[nodiscard]] const Scanner* GetScanner(Level level);
+
+}  // namespace parse::scan
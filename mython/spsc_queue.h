@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace parse {
+
+/*
+ * Ограниченная очередь без блокировок для одного писателя и одного читателя.
+ * Элементы хранятся в кольцевом буфере; писатель продвигает только tail_, читатель - только head_,
+ * поэтому для передачи элемента достаточно записи и чтения одного атомарного индекса.
+ * Одна ячейка буфера всегда пуста, чтобы полная очередь отличалась от пустой.
+ *
+ * Push и Pop сначала недолго повторяют попытку, а затем засыпают на условной переменной.
+ * Мьютекс нужен только для сна: противоположная сторона берёт его, лишь если видит флаг
+ * ожидания, поэтому при непустой и незаполненной очереди передача элемента обходится без блокировок
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : slots_(capacity + 1) {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Число неудачных попыток, после которого Push и Pop засыпают
+    static constexpr int SPIN_LIMIT = 64;
+
+    // Вызывается только писателем. Возвращает false, не трогая value, если очередь заполнена
+    bool TryPush(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = Advance(tail);
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail] = std::move(value);
+        tail_.store(next, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Вызывается только читателем. Возвращает false, если очередь пуста
+    bool TryPop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots_[head]);
+        head_.store(Advance(head), std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Вызывается только писателем. Ждёт свободного места и добавляет value.
+    // Возвращает false, не трогая value, если очередь закрыта вызовом Close
+    bool Push(T&& value) {
+        for (int attempt = 0; !TryPush(std::move(value)); ++attempt) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (attempt < SPIN_LIMIT) {
+                std::this_thread::yield();
+            } else {
+                Wait(writer_waiting_, not_full_, [this] {
+                    return !IsFull() || closed_.load(std::memory_order_relaxed);
+                });
+            }
+        }
+        Wake(reader_waiting_, not_empty_);
+        return true;
+    }
+
+    // Вызывается только читателем. Ждёт, пока в очереди появится элемент, и извлекает его
+    void Pop(T& value) {
+        for (int attempt = 0; !TryPop(value); ++attempt) {
+            if (attempt < SPIN_LIMIT) {
+                std::this_thread::yield();
+            } else {
+                Wait(reader_waiting_, not_empty_, [this] {
+                    return !IsEmpty();
+                });
+            }
+        }
+        Wake(writer_waiting_, not_full_);
+    }
+
+    // Будит писателя, ожидающего места в очереди. Последующие Push возвращают false,
+    // если очередь заполнена
+    void Close() {
+        closed_.store(true, std::memory_order_release);
+        std::lock_guard lock(mutex_);
+        not_full_.notify_one();
+    }
+
+    [[nodiscard]] size_t GetCapacity() const {
+        return slots_.size() - 1;
+    }
+
+private:
+    size_t Advance(size_t index) const {
+        return index + 1 == slots_.size() ? 0 : index + 1;
+    }
+
+    bool IsFull() const {
+        return Advance(tail_.load(std::memory_order_seq_cst))
+            == head_.load(std::memory_order_seq_cst);
+    }
+
+    bool IsEmpty() const {
+        return head_.load(std::memory_order_seq_cst) == tail_.load(std::memory_order_seq_cst);
+    }
+
+    // Засыпает, пока ready() не вернёт true. Флаг waiting устанавливается до проверки условия,
+    // а Wake читает его после изменения индекса. Все эти операции seq_cst, поэтому либо
+    // ожидающий увидит новый индекс, либо Wake увидит флаг и разбудит его
+    template <typename Ready>
+    void Wait(std::atomic<bool>& waiting, std::condition_variable& cv, Ready ready) {
+        std::unique_lock lock(mutex_);
+        waiting.store(true, std::memory_order_seq_cst);
+        cv.wait(lock, ready);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void Wake(std::atomic<bool>& waiting, std::condition_variable& cv) {
+        if (waiting.load(std::memory_order_seq_cst)) {
+            std::lock_guard lock(mutex_);
+            cv.notify_one();
+        }
+    }
+
+    // Индексы лежат в разных кэш-линиях, чтобы писатель и читатель не мешали друг другу
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::vector<T> slots_;
+
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> writer_waiting_{false};
+    std::atomic<bool> reader_waiting_{false};
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+}  // namespace parse
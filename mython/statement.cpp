@@ -1,6 +1,10 @@
 #include "statement.h"
 
+#include "gc.h"
+
+#include <algorithm>
 #include <iostream>
+#include <optional>
 #include <sstream>
 
 using namespace std;
@@ -12,23 +16,103 @@ using runtime::Context;
 using runtime::ObjectHolder;
 
 namespace {
-const string ADD_METHOD = "__add__"s;
-const string INIT_METHOD = "__init__"s;
+const runtime::Symbol INIT_METHOD = "__init__"sv;
+
+// Возвращает true, если node - константа, значение которой не зависит от closure и context
+bool IsConstant(const Statement& node) {
+    return dynamic_cast<const NumericConst*>(&node) != nullptr
+        || dynamic_cast<const StringConst*>(&node) != nullptr
+        || dynamic_cast<const BoolConst*>(&node) != nullptr
+        || dynamic_cast<const None*>(&node) != nullptr;
+}
+
+// Вычисляет узел, все аргументы которого - константы
+ObjectHolder Evaluate(Statement& node) {
+    Closure closure;
+    runtime::DummyContext context;
+    return node.Execute(closure, context);
+}
+
+// Создаёт константу со значением value либо возвращает nullptr для значений других типов
+unique_ptr<Statement> MakeConstant(const ObjectHolder& value) {
+    switch (value.GetKind()) {
+        case runtime::ObjectKind::None:
+            return make_unique<None>();
+        case runtime::ObjectKind::Number:
+            return make_unique<NumericConst>(*value.TryAs<runtime::Number>());
+        case runtime::ObjectKind::Bool:
+            return make_unique<BoolConst>(*value.TryAs<runtime::Bool>());
+        case runtime::ObjectKind::String:
+            return make_unique<StringConst>(runtime::String(value.TryAs<runtime::String>()->GetValue()));
+        default:
+            return nullptr;
+    }
+}
+
+// Заменяет node его значением. Ошибка вычисления (например, деление на ноль) оставляет
+// узел на месте, чтобы она возникла при исполнении программы
+unique_ptr<Statement> FoldConstant(Statement& node) {
+    try {
+        return MakeConstant(Evaluate(node));
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+void OptimizeAll(vector<unique_ptr<Statement>>& nodes) {
+    for (unique_ptr<Statement>& node : nodes) {
+        Optimize(node);
+    }
+}
 }  // namespace
 
+void Optimize(unique_ptr<Statement>& node) {
+    if (unique_ptr<Statement> folded = node->Fold()) {
+        node = std::move(folded);
+    }
+}
+
 ObjectHolder Assignment::Execute(Closure& closure, Context& context) {
-    closure[var_] = rv_.get()->Execute(closure, context); //что если был подан объект, созданный не в дин. памяти?, пока пофиг
-    return closure[var_];
+    ObjectHolder value = rv_.get()->Execute(closure, context); //что если был подан объект, созданный не в дин. памяти?, пока пофиг
+
+    ObjectHolder& variable = slot_ != VariableValue::NO_SLOT ? closure.Slot(slot_) : closure[var_];
+    variable = std::move(value);
+    return variable;
+}
+
+void Assignment::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*rv_);
+    if (slot_ != VariableValue::NO_SLOT) {
+        compiler.Emit(bytecode::OpCode::StoreSlot, static_cast<uint32_t>(slot_));
+    } else {
+        compiler.Emit(bytecode::OpCode::StoreVar, compiler.AddName(var_));
+    }
+}
+
+unique_ptr<Statement> Assignment::Fold() {
+    Optimize(rv_);
+    return nullptr;
+}
+
+Assignment::Assignment(runtime::Symbol var, std::unique_ptr<Statement> rv) : var_(var), rv_(std::move(rv)) {
+}
+
+Assignment::Assignment(runtime::Symbol var, size_t slot, std::unique_ptr<Statement> rv) : var_(var), slot_(slot), rv_(std::move(rv)) {
 }
 
-Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv) : var_(std::move(var)), rv_(std::move(rv)) {
+VariableValue::VariableValue(runtime::Symbol var_name) : var_name_(var_name) {
 }
 
-VariableValue::VariableValue(const std::string& var_name) : var_name_(std::move(var_name)) {
+VariableValue::VariableValue(const std::vector<std::string>& dotted_ids) : VariableValue(std::vector<runtime::Symbol>(dotted_ids.begin(), dotted_ids.end())) {
 }
 
-VariableValue::VariableValue(std::vector<std::string> dotted_ids) : dotted_ids_(std::move(dotted_ids)) {
-    is_doted_ = true;
+VariableValue::VariableValue(std::vector<runtime::Symbol> dotted_ids) : VariableValue(std::move(dotted_ids), NO_SLOT) {
+}
+
+VariableValue::VariableValue(std::vector<runtime::Symbol> dotted_ids, size_t slot) : dotted_ids_(std::move(dotted_ids)), is_doted_(true), slot_(slot) {
+    if (!dotted_ids_.empty()) {
+        field_caches_.resize(dotted_ids_.size() - 1);
+    }
 }
 
 ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context& context) {
@@ -45,7 +129,12 @@ ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context&
 
         ObjectHolder* current_object = nullptr;
 
-        if (auto it = closure.find(dotted_ids_[0]); it != closure.end()) {
+        if (slot_ != NO_SLOT) {
+            if (!closure.IsBound(slot_)) {
+                throw std::runtime_error("Item_not_found_in_closure_666");
+            }
+            current_object = &closure.Slot(slot_);
+        } else if (auto it = closure.find(dotted_ids_[0]); it != closure.end()) {
             current_object = &(it->second);
         } else {
             throw std::runtime_error("Item_not_found_in_closure_666");
@@ -53,7 +142,7 @@ ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context&
 
         for (size_t i = 1; i < dotted_ids_.size(); ++i) {
             if (runtime::ClassInstance* tmp_class_instance = current_object->TryAs<runtime::ClassInstance>(); tmp_class_instance != nullptr) {
-                current_object = &(tmp_class_instance->Fields()[dotted_ids_[i]]);
+                current_object = &field_caches_[i - 1].Get(tmp_class_instance->Fields(), dotted_ids_[i]);
             } else {
                 throw std::runtime_error("Item_not_found_in_closure_555");
             }
@@ -76,6 +165,25 @@ ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context&
     throw std::runtime_error("Bad variable value");
 }
 
+void VariableValue::Compile(bytecode::Compiler& compiler) {
+    if (!is_doted_) {
+        compiler.Emit(bytecode::OpCode::LoadVar, compiler.AddName(var_name_));
+        return;
+    }
+    if (dotted_ids_.size() == 0) {
+        throw std::runtime_error("Zero_doted_items");
+    }
+
+    if (slot_ != NO_SLOT) {
+        compiler.Emit(bytecode::OpCode::LoadSlot, static_cast<uint32_t>(slot_));
+    } else {
+        compiler.Emit(bytecode::OpCode::LoadVar, compiler.AddName(dotted_ids_[0]));
+    }
+    for (size_t i = 1; i < dotted_ids_.size(); ++i) {
+        compiler.Emit(bytecode::OpCode::LoadField, compiler.AddName(dotted_ids_[i]), 0, compiler.AddFieldCache());
+    }
+}
+
 unique_ptr<Print> Print::Variable(const std::string& name) {
     return unique_ptr<Print>(new Print(unique_ptr<Statement>(new VariableValue(name))));
 }
@@ -90,6 +198,8 @@ Print::Print(vector<unique_ptr<Statement>> args) : args_(std::move(args)) {
 
 ObjectHolder Print::Execute(Closure& closure, Context& context) {
     ObjectHolder last_printed_value;
+    // Значение предыдущего аргумента заменяется только после вычисления следующего
+    runtime::GcHeap::Pin pin(last_printed_value);
 
     ostream& os = context.GetOutputStream();
 
@@ -123,149 +233,179 @@ ObjectHolder Print::Execute(Closure& closure, Context& context) {
     return last_printed_value;
 }
 
-MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
-                       std::vector<std::unique_ptr<Statement>> args) : object_(std::move(object)), method_(std::move(method)), args_(std::move(args)) {
+void Print::Compile(bytecode::Compiler& compiler) {
+    if (is_print_args_) {
+        for (const auto& arg : args_) {
+            compiler.Compile(*arg);
+        }
+        compiler.Emit(bytecode::OpCode::Print, static_cast<uint32_t>(args_.size()));
+    } else {
+        compiler.Compile(*argument_);
+        compiler.Emit(bytecode::OpCode::Print, 1);
+    }
+}
+
+unique_ptr<Statement> Print::Fold() {
+    if (is_print_args_) {
+        OptimizeAll(args_);
+    } else {
+        Optimize(argument_);
+    }
+    return nullptr;
+}
+
+MethodCall::MethodCall(std::unique_ptr<Statement> object, runtime::Symbol method,
+                       std::vector<std::unique_ptr<Statement>> args) : object_(std::move(object)), method_(method), args_(std::move(args)) {
 
 }
 
 ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
     ObjectHolder object = object_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin object_pin(object);
 
     if (runtime::ClassInstance* cls_inst = object.TryAs<runtime::ClassInstance>(); cls_inst != nullptr) {
-        if (cls_inst->HasMethod(method_, args_.size())) {
+        if (const runtime::Method* method = cache_.Lookup(cls_inst->GetClass(), method_, args_.size()); method != nullptr) {
             std::vector<ObjectHolder> actual_args;
+            runtime::GcHeap::Pin args_pin(actual_args);
+            actual_args.reserve(args_.size());
             for (const auto& arg : args_) {
                 actual_args.push_back(arg.get()->Execute(closure, context));
             }
-            return cls_inst->Call(method_, actual_args, context);
+            return cls_inst->Call(*method, actual_args, context);
         }
     }
 
     throw std::runtime_error("Bad method call");
 }
 
-ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
-    runtime::ObjectHolder object = argument_.get()->Execute(closure, context);
-
-    if (runtime::String* item = object.TryAs<runtime::String>(); item != nullptr) {
-
-        return runtime::ObjectHolder::Own(runtime::ValueObject(item->GetValue()));
-    } else if (runtime::Number* item = object.TryAs<runtime::Number>(); item != nullptr) {
-
-        return runtime::ObjectHolder::Own(runtime::ValueObject(std::to_string(item->GetValue())));
-    } else if (runtime::Bool* item = object.TryAs<runtime::Bool>(); item != nullptr) {
-
-        if (item->GetValue()) {
-            return runtime::ObjectHolder::Own(runtime::ValueObject("True"));
-        } else {
-            return runtime::ObjectHolder::Own(runtime::ValueObject("False"));
-        }
-    } else if (object.Get() == nullptr) {
-
-        return runtime::ObjectHolder::Own(runtime::ValueObject("None"));
-    } else if (runtime::ClassInstance* item = object.TryAs<runtime::ClassInstance>(); item != nullptr) {
-        if (item->HasMethod("__str__", 0)) {
-            runtime::ObjectHolder new_object = item->Call("__str__", {}, context);
-            if (runtime::String* item_2 = new_object.TryAs<runtime::String>(); item_2 != nullptr) {
+void MethodCall::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*object_);
+    for (const auto& arg : args_) {
+        compiler.Compile(*arg);
+    }
+    compiler.Emit(bytecode::OpCode::CallMethod, compiler.AddName(method_),
+                  static_cast<uint32_t>(args_.size()), compiler.AddMethodCache());
+}
 
-                return runtime::ObjectHolder::Own(runtime::ValueObject(item_2->GetValue()));
-            } else if (runtime::Number* item_2 = new_object.TryAs<runtime::Number>(); item_2 != nullptr) {
+unique_ptr<Statement> MethodCall::Fold() {
+    Optimize(object_);
+    OptimizeAll(args_);
+    return nullptr;
+}
 
-                return runtime::ObjectHolder::Own(runtime::ValueObject(std::to_string(item_2->GetValue())));
-            } else if (runtime::Bool* item_2 = new_object.TryAs<runtime::Bool>(); item_2 != nullptr) {
+unique_ptr<Statement> UnaryOperation::Fold() {
+    Optimize(argument_);
+    return IsConstant(*argument_) ? FoldConstant(*this) : nullptr;
+}
 
-                if (item_2->GetValue()) {
-                    return runtime::ObjectHolder::Own(runtime::ValueObject("True"));
-                } else {
-                    return runtime::ObjectHolder::Own(runtime::ValueObject("False"));
-                }
-            } else if (new_object.Get() == nullptr) {
+unique_ptr<Statement> BinaryOperation::Fold() {
+    Optimize(lhs_);
+    Optimize(rhs_);
+    return IsConstant(*lhs_) && IsConstant(*rhs_) ? FoldConstant(*this) : nullptr;
+}
 
-                return runtime::ObjectHolder::Own(runtime::ValueObject("None"));
-            }
-        }
+ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
+    return runtime::Stringify(argument_.get()->Execute(closure, context), context);
+}
 
-        stringstream ss;
-        ss << item;
-        return runtime::ObjectHolder::Own(runtime::ValueObject(ss.str()));
-    } else {
-        throw std::runtime_error("Bad_stringify");
-    }
+void Stringify::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*argument_);
+    compiler.Emit(bytecode::OpCode::Stringify);
 }
 
 ObjectHolder Add::Execute(Closure& closure, Context& context) {
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
     ObjectHolder rhs = rhs_.get()->Execute(closure, context);
+    return runtime::Add(lhs, rhs, context);
+}
 
-    if (runtime::String* lhs_item = lhs.TryAs<runtime::String>(); lhs_item != nullptr) {
-        if (runtime::String* rhs_item = rhs.TryAs<runtime::String>(); rhs_item != nullptr) {
-            return runtime::ObjectHolder::Own(runtime::ValueObject("" + lhs_item->GetValue() + rhs_item->GetValue()));
-        }
-    } else if (runtime::Number* lhs_item = lhs.TryAs<runtime::Number>(); lhs_item != nullptr) {
-        if (runtime::Number* rhs_item = rhs.TryAs<runtime::Number>(); rhs_item != nullptr) {
-
-            return runtime::ObjectHolder::Own(runtime::ValueObject(lhs_item->GetValue() + rhs_item->GetValue()));
-        }
-    } else if (runtime::ClassInstance* lhs_item = lhs.TryAs<runtime::ClassInstance>(); lhs_item != nullptr) {
-        //if (runtime::ClassInstance* rhs_item = rhs.TryAs<runtime::ClassInstance>(); rhs_item != nullptr) {
-        if (lhs_item->HasMethod("__add__", 1)) {
-
-            return lhs_item->Call("__add__", {rhs}, context);
-        }
-        //}
-    }
-
-    throw std::runtime_error("Bad_Add");
+void Add::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*lhs_);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::Add);
 }
 
 ObjectHolder Sub::Execute(Closure& closure, Context& context) {
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
     ObjectHolder rhs = rhs_.get()->Execute(closure, context);
-    if (runtime::Number* lhs_item = lhs.TryAs<runtime::Number>(); lhs_item != nullptr) {
-        if (runtime::Number* rhs_item = rhs.TryAs<runtime::Number>(); rhs_item != nullptr) {
-            return runtime::ObjectHolder::Own(runtime::ValueObject(lhs_item->GetValue() - rhs_item->GetValue()));
-        }
-    }
+    return runtime::Sub(lhs, rhs);
+}
 
-    throw std::runtime_error("Bad_sub");
+void Sub::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*lhs_);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::Sub);
 }
 
 ObjectHolder Mult::Execute(Closure& closure, Context& context) {
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
     ObjectHolder rhs = rhs_.get()->Execute(closure, context);
-    if (runtime::Number* lhs_item = lhs.TryAs<runtime::Number>(); lhs_item != nullptr) {
-        if (runtime::Number* rhs_item = rhs.TryAs<runtime::Number>(); rhs_item != nullptr) {
-            return runtime::ObjectHolder::Own(runtime::ValueObject(lhs_item->GetValue() * rhs_item->GetValue()));
-        }
-    }
+    return runtime::Mult(lhs, rhs);
+}
 
-    throw std::runtime_error("Bad_mult");
+void Mult::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*lhs_);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::Mult);
 }
 
 ObjectHolder Div::Execute(Closure& closure, Context& context) {
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
     ObjectHolder rhs = rhs_.get()->Execute(closure, context);
-    if (runtime::Number* lhs_item = lhs.TryAs<runtime::Number>(); lhs_item != nullptr) {
-        if (runtime::Number* rhs_item = rhs.TryAs<runtime::Number>(); rhs_item != nullptr) {
-            if (rhs_item->GetValue() != 0) {
-                return runtime::ObjectHolder::Own(runtime::ValueObject(lhs_item->GetValue() / rhs_item->GetValue()));
-            }
-        }
-    }
+    return runtime::Div(lhs, rhs);
+}
 
-    throw std::runtime_error("Bad_div");
+void Div::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*lhs_);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::Div);
 }
 
 ObjectHolder Compound::Execute(Closure& closure, Context& context) {
     for (const std::unique_ptr<Statement>& statement : statements_) {
-        statement.get()->Execute(closure, context);
+        ObjectHolder result = statement.get()->Execute(closure, context);
+        if (closure.GetCompletion() != runtime::Completion::Normal) {
+            return result;
+        }
     }
 
     return {};
 }
 
+void Compound::Compile(bytecode::Compiler& compiler) {
+    for (const std::unique_ptr<Statement>& statement : statements_) {
+        compiler.Compile(*statement);
+        compiler.Emit(bytecode::OpCode::Pop);
+    }
+    compiler.Emit(bytecode::OpCode::PushNone);
+}
+
+unique_ptr<Statement> Compound::Fold() {
+    OptimizeAll(statements_);
+    statements_.erase(remove_if(statements_.begin(), statements_.end(), [](const unique_ptr<Statement>& statement) {
+        return IsConstant(*statement);
+    }), statements_.end());
+    return nullptr;
+}
+
 ObjectHolder Return::Execute(Closure& closure, Context& context) {
-    throw statement_.get()->Execute(closure, context);
+    ObjectHolder result = statement_.get()->Execute(closure, context);
+    closure.SetCompletion(runtime::Completion::Return);
+    return result;
+}
+
+void Return::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*statement_);
+    compiler.Emit(bytecode::OpCode::Return);
+}
+
+unique_ptr<Statement> Return::Fold() {
+    Optimize(statement_);
+    return nullptr;
 }
 
 ClassDefinition::ClassDefinition(ObjectHolder cls) : cls_(cls) {
@@ -278,19 +418,25 @@ ObjectHolder ClassDefinition::Execute(Closure& closure, [[maybe_unused]] Context
     return closure[class_name];
 }
 
-FieldAssignment::FieldAssignment(VariableValue object, std::string field_name,
-                                 std::unique_ptr<Statement> rv) : object_(std::move(object)), field_name_(std::move(field_name)), rv_(std::move(rv)) {
+void ClassDefinition::Compile(bytecode::Compiler& compiler) {
+    compiler.CompileMethods(*cls_.TryAs<runtime::Class>());
+    compiler.Emit(bytecode::OpCode::DefineClass, compiler.AddConstant(cls_));
+}
+
+FieldAssignment::FieldAssignment(VariableValue object, runtime::Symbol field_name,
+                                 std::unique_ptr<Statement> rv) : object_(std::move(object)), field_name_(field_name), rv_(std::move(rv)) {
 }
 
 ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
     runtime::ObjectHolder current_object = object_.Execute(closure, context);
-
+    runtime::GcHeap::Pin pin(current_object);
 
     if (runtime::ClassInstance* tmp_class_instance = current_object.TryAs<runtime::ClassInstance>(); tmp_class_instance != nullptr) {
 
-        tmp_class_instance->Fields()[field_name_] = rv_.get()->Execute(closure, context);
-
-        return tmp_class_instance->Fields()[field_name_];
+        ObjectHolder value = rv_.get()->Execute(closure, context);
+        ObjectHolder& field = field_cache_.Get(tmp_class_instance->Fields(), field_name_);
+        field = std::move(value);
+        return field;
     } else if (runtime::String* tmp_str = current_object.TryAs<runtime::String>(); tmp_class_instance != nullptr) {
         if (auto it = closure.find(tmp_str->GetValue()); it != closure.end()) {
             it->second = rv_.get()->Execute(closure, context);
@@ -300,14 +446,27 @@ ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
     throw std::runtime_error("bad field assignment");
 }
 
+void FieldAssignment::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(object_);
+    compiler.Compile(*rv_);
+    compiler.Emit(bytecode::OpCode::StoreField, compiler.AddName(field_name_), 0, compiler.AddFieldCache());
+}
+
+unique_ptr<Statement> FieldAssignment::Fold() {
+    Optimize(rv_);
+    return nullptr;
+}
+
 IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
                std::unique_ptr<Statement> else_body) : condition_(std::move(condition)), if_body_(std::move(if_body)), else_body_(std::move(else_body)) {
 }
 
 ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
-    ObjectHolder condition = condition_.get()->Execute(closure, context);
+    // Значение условия не удерживается во время исполнения ветки: в ней может оказаться
+    // безопасная точка сборки мусора (см. While)
+    const bool condition = IsTrue(condition_.get()->Execute(closure, context));
 
-    if (IsTrue(condition)) {
+    if (condition) {
         return if_body_.get()->Execute(closure, context);
     } else {
         if (else_body_.get() != nullptr) {
@@ -318,9 +477,115 @@ ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
     }
 }
 
+void IfElse::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*condition_);
+    const size_t to_else = compiler.EmitJump(bytecode::OpCode::JumpIfFalse);
+
+    compiler.Compile(*if_body_);
+    const size_t to_end = compiler.EmitJump(bytecode::OpCode::Jump);
+
+    compiler.PatchJump(to_else);
+    if (else_body_.get() != nullptr) {
+        compiler.Compile(*else_body_);
+    } else {
+        compiler.Emit(bytecode::OpCode::PushNone);
+    }
+    compiler.PatchJump(to_end);
+}
+
+unique_ptr<Statement> IfElse::Fold() {
+    Optimize(condition_);
+    Optimize(if_body_);
+    if (else_body_.get() != nullptr) {
+        Optimize(else_body_);
+    }
+    if (!IsConstant(*condition_)) {
+        return nullptr;
+    }
+
+    if (IsTrue(Evaluate(*condition_))) {
+        return std::move(if_body_);
+    }
+    if (else_body_.get() != nullptr) {
+        return std::move(else_body_);
+    }
+    return make_unique<None>();
+}
+
+While::While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body)
+    : condition_(std::move(condition)), body_(std::move(body)) {
+}
+
+ObjectHolder While::Execute(Closure& closure, Context& context) {
+    for (;;) {
+        runtime::GcHeap::SafePoint();
+        if (!IsTrue(condition_.get()->Execute(closure, context))) {
+            return {};
+        }
+
+        ObjectHolder result = body_.get()->Execute(closure, context);
+        switch (closure.GetCompletion()) {
+            case runtime::Completion::Normal:
+                break;
+            case runtime::Completion::Continue:
+                closure.SetCompletion(runtime::Completion::Normal);
+                break;
+            case runtime::Completion::Break:
+                closure.SetCompletion(runtime::Completion::Normal);
+                return {};
+            case runtime::Completion::Return:
+                return result;
+        }
+    }
+}
+
+void While::Compile(bytecode::Compiler& compiler) {
+    // Безопасные точки цикла верхнего уровня VM проходит сама, снимая результаты инструкций тела
+    compiler.BeginLoop();
+    compiler.Compile(*condition_);
+    const size_t to_end = compiler.EmitJump(bytecode::OpCode::JumpIfFalse);
+
+    compiler.Compile(*body_);
+    compiler.Emit(bytecode::OpCode::Pop);
+    compiler.EmitContinue();
+
+    compiler.PatchJump(to_end);
+    compiler.EndLoop();
+    compiler.Emit(bytecode::OpCode::PushNone);
+}
+
+unique_ptr<Statement> While::Fold() {
+    Optimize(condition_);
+    Optimize(body_);
+    // Цикл с ложным условием не исполняется ни разу
+    if (IsConstant(*condition_) && !IsTrue(Evaluate(*condition_))) {
+        return make_unique<None>();
+    }
+    return nullptr;
+}
+
+ObjectHolder Break::Execute(Closure& closure, [[maybe_unused]] Context& context) {
+    closure.SetCompletion(runtime::Completion::Break);
+    return {};
+}
+
+void Break::Compile(bytecode::Compiler& compiler) {
+    compiler.EmitBreak();
+}
+
+ObjectHolder Continue::Execute(Closure& closure, [[maybe_unused]] Context& context) {
+    closure.SetCompletion(runtime::Completion::Continue);
+    return {};
+}
+
+void Continue::Compile(bytecode::Compiler& compiler) {
+    compiler.EmitContinue();
+}
+
 ObjectHolder Or::Execute(Closure& closure, Context& context) {
 
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
     if (lhs) {
         if (IsTrue(lhs)) {
             return runtime::ObjectHolder::Own(runtime::Bool(true));
@@ -339,9 +604,34 @@ ObjectHolder Or::Execute(Closure& closure, Context& context) {
     throw std::runtime_error("Bad_or");
 }
 
+void Or::Compile(bytecode::Compiler& compiler) {
+    const auto op = static_cast<uint32_t>(bytecode::LogicalOp::Or);
+
+    compiler.Compile(*lhs_);
+    compiler.Emit(bytecode::OpCode::ToBool, op);
+    const size_t to_end = compiler.EmitJump(bytecode::OpCode::JumpIfTrueOrPop);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::ToBool, op);
+    compiler.PatchJump(to_end);
+}
+
+unique_ptr<Statement> Or::Fold() {
+    Optimize(lhs_);
+    Optimize(rhs_);
+    if (!IsConstant(*lhs_)) {
+        return nullptr;
+    }
+    ObjectHolder lhs = Evaluate(*lhs_);
+    if (lhs && IsTrue(lhs)) {
+        return make_unique<BoolConst>(runtime::Bool(true));
+    }
+    return IsConstant(*rhs_) ? FoldConstant(*this) : nullptr;
+}
+
 ObjectHolder And::Execute(Closure& closure, Context& context) {
 
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
 
     if (lhs) {
         if (IsTrue(lhs)) {
@@ -361,6 +651,30 @@ ObjectHolder And::Execute(Closure& closure, Context& context) {
     throw std::runtime_error("Bad_and");
 }
 
+void And::Compile(bytecode::Compiler& compiler) {
+    const auto op = static_cast<uint32_t>(bytecode::LogicalOp::And);
+
+    compiler.Compile(*lhs_);
+    compiler.Emit(bytecode::OpCode::ToBool, op);
+    const size_t to_end = compiler.EmitJump(bytecode::OpCode::JumpIfFalseOrPop);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::ToBool, op);
+    compiler.PatchJump(to_end);
+}
+
+unique_ptr<Statement> And::Fold() {
+    Optimize(lhs_);
+    Optimize(rhs_);
+    if (!IsConstant(*lhs_)) {
+        return nullptr;
+    }
+    ObjectHolder lhs = Evaluate(*lhs_);
+    if (lhs && !IsTrue(lhs)) {
+        return make_unique<BoolConst>(runtime::Bool(false));
+    }
+    return IsConstant(*rhs_) ? FoldConstant(*this) : nullptr;
+}
+
 ObjectHolder Not::Execute(Closure& closure, Context& context) {
     ObjectHolder arg = argument_.get()->Execute(closure, context);
 
@@ -375,6 +689,11 @@ ObjectHolder Not::Execute(Closure& closure, Context& context) {
     throw std::runtime_error("Bad_not");
 }
 
+void Not::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*argument_);
+    compiler.Emit(bytecode::OpCode::Not);
+}
+
 Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
     : BinaryOperation(std::move(lhs), std::move(rhs)), cmp_(cmp) {
 
@@ -382,6 +701,7 @@ Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Sta
 
 ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
     ObjectHolder lhs = lhs_.get()->Execute(closure, context);
+    runtime::GcHeap::Pin pin(lhs);
     ObjectHolder rhs = rhs_.get()->Execute(closure, context);
 
     bool result = cmp_(lhs, rhs, context);
@@ -393,6 +713,12 @@ ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
     }
 }
 
+void Comparison::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*lhs_);
+    compiler.Compile(*rhs_);
+    compiler.Emit(bytecode::OpCode::Compare, compiler.AddComparator(cmp_));
+}
+
 NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args) : class__(class_), args_(std::move(args)) {
 
 }
@@ -403,10 +729,12 @@ NewInstance::NewInstance(const runtime::Class& class_) : class__(class_) {
 
 ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
     ObjectHolder new_class = ObjectHolder::Own(runtime::ClassInstance(class__));
+    runtime::GcHeap::Pin instance_pin(new_class);
 
     if (runtime::ClassInstance* class_instance = new_class.TryAs<runtime::ClassInstance>(); class_instance != nullptr) {
         if (class_instance->HasMethod(INIT_METHOD, args_.size())) {
             std::vector<ObjectHolder> actual_args;
+            runtime::GcHeap::Pin args_pin(actual_args);
             for (const auto& arg : args_) {
                 actual_args.push_back(arg.get()->Execute(closure, context));
             }
@@ -417,17 +745,80 @@ ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
     return new_class;
 }
 
+void NewInstance::Compile(bytecode::Compiler& compiler) {
+    // Класс неизменяем, поэтому наличие подходящего __init__ известно уже при компиляции
+    const runtime::Method* init = class__.GetMethod(INIT_METHOD);
+    if (init == nullptr || init->formal_params.size() != args_.size()) {
+        compiler.Emit(bytecode::OpCode::NewInstance, compiler.AddClass(class__));
+        return;
+    }
+
+    for (const auto& arg : args_) {
+        compiler.Compile(*arg);
+    }
+    compiler.Emit(bytecode::OpCode::Construct, compiler.AddClass(class__),
+                  static_cast<uint32_t>(args_.size()));
+}
+
+unique_ptr<Statement> NewInstance::Fold() {
+    OptimizeAll(args_);
+    return nullptr;
+}
+
+Program::Program(runtime::ArenaPtr arena, std::unique_ptr<Compound> body) : body_(std::move(body)) {
+    arenas_.push_back(std::move(arena));
+}
+
+Program::Program(std::vector<runtime::ArenaPtr> arenas, std::unique_ptr<Compound> body) : arenas_(std::move(arenas)), body_(std::move(body)) {
+}
+
+ObjectHolder Program::Execute(Closure& closure, Context& context) {
+    std::optional<runtime::GcHeap::Root> root;
+    if (runtime::GcHeap* heap = runtime::GcHeap::GetCurrent()) {
+        root.emplace(*heap, closure);
+    }
+
+    for (const std::unique_ptr<Statement>& statement : body_->GetStatements()) {
+        {
+            ObjectHolder result = statement.get()->Execute(closure, context);
+            if (closure.GetCompletion() != runtime::Completion::Normal) {
+                return result;
+            }
+        }
+        runtime::GcHeap::SafePoint();
+    }
+
+    return {};
+}
+
+void Program::Compile(bytecode::Compiler& compiler) {
+    compiler.Compile(*body_);
+}
+
 MethodBody::MethodBody(std::unique_ptr<Statement> body) : body_(std::move(body)) {
 }
 
 ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-    try {
-        body_.get()->Execute(closure, context);
-    } catch (ObjectHolder object) {
-        return object;
+    ObjectHolder result = body_.get()->Execute(closure, context);
+
+    if (closure.GetCompletion() == runtime::Completion::Return) {
+        closure.SetCompletion(runtime::Completion::Normal);
+        return result;
     }
 
     return {};
 }
 
+void MethodBody::Compile(bytecode::Compiler& compiler) {
+    // Инструкция return внутри body завершает фрагмент сама, иначе метод возвращает None
+    compiler.Compile(*body_);
+    compiler.Emit(bytecode::OpCode::Pop);
+    compiler.Emit(bytecode::OpCode::PushNone);
+}
+
+unique_ptr<Statement> MethodBody::Fold() {
+    Optimize(body_);
+    return nullptr;
+}
+
 }  // namespace ast
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "arena.h"
+#include "bytecode.h"
 #include "runtime.h"
 
 #include <functional>
@@ -9,6 +11,9 @@ namespace ast {
 
 using Statement = runtime::Executable;
 
+// Сворачивает константные подвыражения node и заменяет node результатом, если он изменился
+void Optimize(std::unique_ptr<Statement>& node);
+
 // Выражение, возвращающее значение типа T,
 // используется как основа для создания констант
 template <typename T>
@@ -20,10 +25,28 @@ public:
 
     runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
                                   runtime::Context& /*context*/) override {
-        return runtime::ObjectHolder::Share(value_);
+        return Value();
+    }
+
+    void Compile(bytecode::Compiler& compiler) override {
+        compiler.EmitConstant(Value());
+    }
+
+    [[nodiscard]] const T& GetValue() const {
+        return value_;
     }
 
 private:
+    // Числа и логические значения копируются внутрь ObjectHolder без выделения памяти,
+    // на остальные константы возвращается ссылка
+    runtime::ObjectHolder Value() {
+        if constexpr (runtime::ObjectHolder::IS_INLINE<T>) {
+            return runtime::ObjectHolder::Own(T(value_));
+        } else {
+            return runtime::ObjectHolder::Share(value_);
+        }
+    }
+
     T value_;
 };
 
@@ -38,37 +61,69 @@ x = circle.center.x
 */
 class VariableValue : public Statement {
 public:
-    explicit VariableValue(const std::string& var_name);
-    explicit VariableValue(std::vector<std::string> dotted_ids);
+    // Номер слота для переменных, не разрешённых при разборе: их значения ищутся в Closure по имени
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    explicit VariableValue(runtime::Symbol var_name);
+    explicit VariableValue(const std::vector<std::string>& dotted_ids);
+    explicit VariableValue(std::vector<runtime::Symbol> dotted_ids);
+    // Первый идентификатор цепочки - локальная переменная метода, хранящаяся в слоте slot кадра
+    VariableValue(std::vector<runtime::Symbol> dotted_ids, size_t slot);
+
+    // Первый идентификатор цепочки
+    [[nodiscard]] runtime::Symbol GetRootName() const {
+        return dotted_ids_.front();
+    }
+    // Связывает первый идентификатор цепочки со слотом кадра. Разборщик вызывает метод,
+    // когда имя оказывается локальной переменной метода, присваиваемой после этого чтения
+    void BindSlot(size_t slot) {
+        slot_ = slot;
+    }
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 protected:
-    std::string var_name_;
-    std::vector<std::string> dotted_ids_;
+    runtime::Symbol var_name_;
+    std::vector<runtime::Symbol> dotted_ids_;
     bool is_doted_ = false;
+    size_t slot_ = NO_SLOT;
+    // Кэши доступа к полям dotted_ids_[1..]: field_caches_[i - 1] для dotted_ids_[i]
+    std::vector<runtime::FieldCache> field_caches_;
 };
 
 // Присваивает переменной, имя которой задано в параметре var, значение выражения rv
 class Assignment : public Statement {
 public:
-    Assignment(std::string var, std::unique_ptr<Statement> rv);
+    Assignment(runtime::Symbol var, std::unique_ptr<Statement> rv);
+    // Присваивает значение локальной переменной метода, хранящейся в слоте slot кадра
+    Assignment(runtime::Symbol var, size_t slot, std::unique_ptr<Statement> rv);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
-    std::string var_;
+    runtime::Symbol var_;
+    size_t slot_ = VariableValue::NO_SLOT;
     std::unique_ptr<Statement> rv_;
 };
 
 // Присваивает полю object.field_name значение выражения rv
 class FieldAssignment : public Statement {
 public:
-    FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
+    FieldAssignment(VariableValue object, runtime::Symbol field_name, std::unique_ptr<Statement> rv);
+
+    [[nodiscard]] VariableValue& GetObject() {
+        return object_;
+    }
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
     VariableValue object_;
-    std::string field_name_;
+    runtime::Symbol field_name_;
     std::unique_ptr<Statement> rv_;
+    runtime::FieldCache field_cache_;
 };
 
 // Значение None
@@ -78,6 +133,10 @@ public:
                                   [[maybe_unused]] runtime::Context& context) override {
         return {};
     }
+
+    void Compile(bytecode::Compiler& compiler) override {
+        compiler.Emit(bytecode::OpCode::PushNone);
+    }
 };
 
 // Команда print
@@ -94,6 +153,8 @@ public:
     // Во время выполнения команды print вывод должен осуществляться в поток, возвращаемый из
     // context.GetOutputStream()
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::vector<std::unique_ptr<Statement>> args_;
     std::unique_ptr<Statement> argument_;
@@ -103,14 +164,18 @@ protected:
 // Вызывает метод object.method со списком параметров args
 class MethodCall : public Statement {
 public:
-    MethodCall(std::unique_ptr<Statement> object, std::string method,
+    MethodCall(std::unique_ptr<Statement> object, runtime::Symbol method,
                std::vector<std::unique_ptr<Statement>> args);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::unique_ptr<Statement> object_;
-    std::string method_;
+    runtime::Symbol method_;
     std::vector<std::unique_ptr<Statement>> args_;
+    // Кэш методов, вызванных в этом месте программы
+    runtime::MethodCache cache_;
 };
 
 /*
@@ -132,6 +197,8 @@ public:
     NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args);
     // Возвращает объект, содержащий значение типа ClassInstance
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
     const runtime::Class& class__;
     std::vector<std::unique_ptr<Statement>> args_;
@@ -143,6 +210,9 @@ public:
     explicit UnaryOperation(std::unique_ptr<Statement> argument) : argument_(std::move(argument)) {
 
     }
+
+    // Если аргумент - константа, заменяет операцию её результатом
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::unique_ptr<Statement> argument_;
 };
@@ -152,6 +222,7 @@ class Stringify : public UnaryOperation {
 public:
     using UnaryOperation::UnaryOperation;
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 };
 
 // Родительский класс Бинарная операция с аргументами lhs и rhs
@@ -160,6 +231,10 @@ public:
     BinaryOperation(std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
 
     }
+
+    // Если оба аргумента - константы, заменяет операцию её результатом.
+    // Операции, которые при вычислении выбрасывают исключение, остаются до исполнения
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::unique_ptr<Statement> lhs_;
     std::unique_ptr<Statement> rhs_;
@@ -176,6 +251,7 @@ public:
     //  объект1 + объект2, если у объект1 - пользовательский класс с методом _add__(rhs)
     // В противном случае при вычислении выбрасывается runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 };
 
 // Возвращает результат вычитания аргументов lhs и rhs
@@ -187,6 +263,7 @@ public:
     //  число - число
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 };
 
 // Возвращает результат умножения аргументов lhs и rhs
@@ -198,6 +275,7 @@ public:
     //  число * число
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 };
 
 // Возвращает результат деления lhs и rhs
@@ -210,6 +288,7 @@ public:
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     // Если rhs равен 0, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 };
 
 // Возвращает результат вычисления логической операции or над lhs и rhs
@@ -219,6 +298,9 @@ public:
     // Значение аргумента rhs вычисляется, только если значение lhs
     // после приведения к Bool равно False
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    // True or rhs сворачивается в True, даже если rhs - не константа
+    std::unique_ptr<Statement> Fold() override;
 };
 
 // Возвращает результат вычисления логической операции and над lhs и rhs
@@ -228,6 +310,9 @@ public:
     // Значение аргумента rhs вычисляется, только если значение lhs
     // после приведения к Bool равно True
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    // False and rhs сворачивается в False, даже если rhs - не константа
+    std::unique_ptr<Statement> Fold() override;
 };
 
 // Возвращает результат вычисления логической операции not над единственным аргументом операции
@@ -235,6 +320,7 @@ class Not : public UnaryOperation {
 public:
     using UnaryOperation::UnaryOperation;
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 };
 
 // Составная инструкция (например: тело метода, содержимое ветки if, либо else)
@@ -251,12 +337,56 @@ public:
         statements_.push_back(std::move(stmt));
     }
 
-    // Последовательно выполняет добавленные инструкции. Возвращает None
+    // Переносит инструкции other в конец составной инструкции
+    void Append(Compound&& other) {
+        for (auto& stmt : other.statements_) {
+            statements_.push_back(std::move(stmt));
+        }
+        other.statements_.clear();
+    }
+
+    // Последовательно выполняет добавленные инструкции. Возвращает None.
+    // Если инструкция завершилась не штатно (например, return), исполнение прекращается
+    // и возвращается её результат
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    // Сворачивает инструкции и удаляет те, что свелись к константам: они ни на что не влияют
+    std::unique_ptr<Statement> Fold() override;
+
+    [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetStatements() const {
+        return statements_;
+    }
 protected:
     std::vector<std::unique_ptr<Statement>> statements_;
 };
 
+// Корень разобранной программы. Владеет аренами, в которых размещены узлы её дерева
+class Program : public Statement {
+public:
+    Program(runtime::ArenaPtr arena, std::unique_ptr<Compound> body);
+    // Узлы программы, части которой разобраны параллельно, размещены в аренах этих частей
+    Program(std::vector<runtime::ArenaPtr> arenas, std::unique_ptr<Compound> body);
+
+    // Исполняет инструкции верхнего уровня. Если текущая куча GcHeap есть, closure служит её корнем,
+    // а между инструкциями находятся безопасные точки сборки мусора
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+
+    // Возвращает арену первой части программы
+    [[nodiscard]] const runtime::Arena& GetArena() const {
+        return *arenas_.front();
+    }
+
+    [[nodiscard]] size_t GetArenaCount() const {
+        return arenas_.size();
+    }
+
+private:
+    // Узлы дерева уничтожаются раньше ссылок на арены
+    std::vector<runtime::ArenaPtr> arenas_;
+    std::unique_ptr<Compound> body_;
+};
+
 // Тело метода. Как правило, содержит составную инструкцию
 class MethodBody : public Statement {
 public:
@@ -266,6 +396,8 @@ public:
     // Если внутри body была выполнена инструкция return, возвращает результат return
     // В противном случае возвращает None
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::unique_ptr<Statement> body_;
 };
@@ -279,7 +411,10 @@ public:
 
     // Останавливает выполнение текущего метода. После выполнения инструкции return метод,
     // внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
+    // Возвращает этот результат, отмечая в closure завершение Completion::Return
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::unique_ptr<Statement> statement_;
 };
@@ -293,6 +428,7 @@ public:
     // Создаёт внутри closure новый объект, совпадающий с именем класса и значением, переданным в
     // конструктор
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 protected:
     runtime::ObjectHolder cls_;
 };
@@ -304,13 +440,50 @@ public:
     IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
            std::unique_ptr<Statement> else_body);
 
+    // Возвращает результат исполненной ветки, поэтому результат return внутри неё
+    // передаётся объемлющей составной инструкции
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    // Если условие - константа, заменяет инструкцию веткой, которая будет исполнена
+    std::unique_ptr<Statement> Fold() override;
 protected:
     std::unique_ptr<Statement> condition_;
     std::unique_ptr<Statement> if_body_;
     std::unique_ptr<Statement> else_body_;
 };
 
+// Инструкция while <condition>: <body>
+class While : public Statement {
+public:
+    // Цикл проходит безопасную точку сборки мусора перед каждой проверкой условия
+    While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body);
+
+    // Исполняет body, пока condition приводится к True. Итерации не выделяют память:
+    // break и continue передаются через завершение Closure, а не исключениями.
+    // Инструкция return внутри body завершает цикл, и её результат передаётся наружу
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+    std::unique_ptr<Statement> Fold() override;
+protected:
+    std::unique_ptr<Statement> condition_;
+    std::unique_ptr<Statement> body_;
+};
+
+// Инструкция break: завершает ближайший объемлющий цикл, отмечая в closure Completion::Break
+class Break : public Statement {
+public:
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+};
+
+// Инструкция continue: переходит к проверке условия ближайшего объемлющего цикла,
+// отмечая в closure Completion::Continue
+class Continue : public Statement {
+public:
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
+};
+
 // Операция сравнения
 class Comparison : public BinaryOperation {
 public:
@@ -323,6 +496,7 @@ public:
     // Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
     // приведённый к типу runtime::Bool
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(bytecode::Compiler& compiler) override;
 protected:
     Comparator cmp_;
 };
@@ -453,6 +453,86 @@ void TestNot() {
     test_not(false);
 }
 
+void TestReturn() {
+    runtime::DummyContext context;
+
+    auto if_body = make_unique<Compound>(make_unique<Return>(make_unique<NumericConst>(2)));
+    MethodBody body{make_unique<Compound>(
+        make_unique<Assignment>("x"s, make_unique<NumericConst>(1)),
+        make_unique<IfElse>(make_unique<BoolConst>(true), std::move(if_body), nullptr),
+        make_unique<Assignment>("x"s, make_unique<NumericConst>(3)))};
+
+    Closure closure;
+    ObjectHolder result = body.Execute(closure, context);
+
+    ASSERT_OBJECT_VALUE_EQUAL(result, 2);
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("x"s), 1);
+    ASSERT(closure.GetCompletion() == runtime::Completion::Normal);
+
+    MethodBody without_return{make_unique<Compound>(
+        make_unique<Assignment>("x"s, make_unique<NumericConst>(4)))};
+    ASSERT(!without_return.Execute(closure, context));
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("x"s), 4);
+}
+
+void TestConstantFolding() {
+    Closure closure;
+    runtime::DummyContext context;
+
+    unique_ptr<Statement> sum = make_unique<Add>(
+        make_unique<Mult>(make_unique<NumericConst>(2), make_unique<NumericConst>(3)),
+        make_unique<NumericConst>(4));
+    Optimize(sum);
+    ASSERT(dynamic_cast<NumericConst*>(sum.get()) != nullptr);
+    ASSERT_OBJECT_VALUE_EQUAL(sum->Execute(closure, context), 10);
+
+    unique_ptr<Statement> str = make_unique<Add>(make_unique<StringConst>("Hello, "s),
+                                                 make_unique<Stringify>(make_unique<NumericConst>(42)));
+    Optimize(str);
+    ASSERT(dynamic_cast<StringConst*>(str.get()) != nullptr);
+    ASSERT_EQUAL(str->Execute(closure, context).TryAs<runtime::String>()->GetValue(), "Hello, 42"s);
+
+    unique_ptr<Statement> less = make_unique<Not>(make_unique<Comparison>(
+        runtime::Less, make_unique<NumericConst>(1), make_unique<NumericConst>(2)));
+    Optimize(less);
+    ASSERT(dynamic_cast<BoolConst*>(less.get()) != nullptr);
+    ASSERT(!runtime::IsTrue(less->Execute(closure, context)));
+
+    // Правый аргумент не вычисляется, поэтому может быть не константой
+    unique_ptr<Statement> short_circuit = make_unique<And>(make_unique<BoolConst>(false),
+                                                           make_unique<VariableValue>("x"s));
+    Optimize(short_circuit);
+    ASSERT(dynamic_cast<BoolConst*>(short_circuit.get()) != nullptr);
+
+    // Ошибки вычисления остаются до исполнения программы
+    unique_ptr<Statement> division = make_unique<Div>(make_unique<NumericConst>(1), make_unique<NumericConst>(0));
+    Optimize(division);
+    ASSERT(dynamic_cast<Div*>(division.get()) != nullptr);
+
+    unique_ptr<Statement> branch = make_unique<IfElse>(
+        make_unique<Comparison>(runtime::Equal, make_unique<NumericConst>(1), make_unique<NumericConst>(1)),
+        make_unique<Compound>(make_unique<Assignment>("x"s, make_unique<NumericConst>(1))),
+        make_unique<Compound>(make_unique<Assignment>("x"s, make_unique<NumericConst>(2))));
+    Optimize(branch);
+    auto* body = dynamic_cast<Compound*>(branch.get());
+    ASSERT(body != nullptr);
+    ASSERT_EQUAL(body->GetStatements().size(), 1U);
+    branch->Execute(closure, context);
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("x"s), 1);
+
+    // Ветка if без else с ложным условием исчезает из составной инструкции
+    unique_ptr<Statement> compound = make_unique<Compound>(
+        make_unique<IfElse>(make_unique<BoolConst>(false),
+                            make_unique<Compound>(make_unique<Assignment>("x"s, make_unique<NumericConst>(3))),
+                            nullptr),
+        make_unique<Assignment>("y"s, make_unique<Sub>(make_unique<NumericConst>(5), make_unique<NumericConst>(7))));
+    Optimize(compound);
+    ASSERT_EQUAL(static_cast<Compound&>(*compound).GetStatements().size(), 1U);
+    compound->Execute(closure, context);
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("x"s), 1);
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("y"s), -2);
+}
+
 }  // namespace
 
 void RunUnitTests(TestRunner& tr) {
@@ -476,6 +556,8 @@ void RunUnitTests(TestRunner& tr) {
     RUN_TEST(tr, ast::TestOr);
     RUN_TEST(tr, ast::TestAnd);
     RUN_TEST(tr, ast::TestNot);
+    RUN_TEST(tr, ast::TestReturn);
+    RUN_TEST(tr, ast::TestConstantFolding);
 }
 
 }  // namespace ast
\ No newline at end of file
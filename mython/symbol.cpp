@@ -0,0 +1,89 @@
+#include "symbol.h"
+
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+// Глобальная таблица символов. Имена хранятся в deque, чтобы ссылки на них не инвалидировались
+// при добавлении новых символов. Доступ защищён мьютексом: символы могут создаваться из разных потоков
+class SymbolTable {
+public:
+    static SymbolTable& Instance() {
+        static SymbolTable table;
+        return table;
+    }
+
+    uint32_t Intern(string_view name) {
+        // Символы, уже созданные в этом потоке, находятся без блокировки общей таблицы,
+        // поэтому лексеры, параллельно работающие в разных потоках, не ждут друг друга
+        thread_local unordered_map<string_view, uint32_t> thread_ids;
+        if (auto it = thread_ids.find(name); it != thread_ids.end()) {
+            return it->second;
+        }
+
+        lock_guard guard(mutex_);
+        auto it = ids_.find(name);
+        if (it == ids_.end()) {
+            const auto id = static_cast<uint32_t>(names_.size());
+            const string& stored = names_.emplace_back(name);
+            it = ids_.emplace(stored, id).first;
+        }
+        thread_ids.insert(*it);
+        return it->second;
+    }
+
+    const string& GetName(uint32_t id) {
+        lock_guard guard(mutex_);
+        return names_[id];
+    }
+
+    size_t GetSize() {
+        lock_guard guard(mutex_);
+        return names_.size();
+    }
+
+private:
+    SymbolTable() {
+        // Символ с номером 0 - пустое имя, его имеет символ, созданный конструктором по умолчанию
+        Intern(""sv);
+    }
+
+    mutex mutex_;
+    deque<string> names_;
+    unordered_map<string_view, uint32_t> ids_;
+};
+
+}  // namespace
+
+Symbol::Symbol(string_view name)
+    : id_(SymbolTable::Instance().Intern(name)) {
+}
+
+Symbol::Symbol(const string& name)
+    : Symbol(string_view(name)) {
+}
+
+Symbol::Symbol(const char* name)
+    : Symbol(string_view(name)) {
+}
+
+const string& Symbol::GetName() const {
+    return SymbolTable::Instance().GetName(id_);
+}
+
+size_t GetSymbolCount() {
+    return SymbolTable::Instance().GetSize();
+}
+
+ostream& operator<<(ostream& os, Symbol symbol) {
+    return os << symbol.GetName();
+}
+
+}  // namespace runtime
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace runtime {
+
+/*
+ * Символ - интернированное имя (идентификатор, имя метода или поля).
+ * Все символы с одинаковым именем имеют один и тот же номер, поэтому символы сравниваются
+ * и хэшируются как целые числа, а само имя хранится в глобальной таблице символов один раз.
+ * Символ неявно создаётся из строки, что позволяет передавать строки туда, где ожидается символ
+ */
+class Symbol {
+public:
+    // Создаёт символ пустого имени
+    Symbol() = default;
+
+    Symbol(std::string_view name);  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+    Symbol(const std::string& name);  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+    Symbol(const char* name);  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+
+    // Возвращает номер символа в таблице символов
+    [[nodiscard]] std::uint32_t GetId() const {
+        return id_;
+    }
+
+    // Возвращает имя символа. Ссылка остаётся действительной до конца работы программы
+    [[nodiscard]] const std::string& GetName() const;
+
+    bool operator==(Symbol rhs) const {
+        return id_ == rhs.id_;
+    }
+
+    bool operator!=(Symbol rhs) const {
+        return id_ != rhs.id_;
+    }
+
+    // Упорядочивает символы по номерам, а не по именам
+    bool operator<(Symbol rhs) const {
+        return id_ < rhs.id_;
+    }
+
+private:
+    std::uint32_t id_ = 0;
+};
+
+// Возвращает число символов в глобальной таблице символов
+size_t GetSymbolCount();
+
+std::ostream& operator<<(std::ostream& os, Symbol symbol);
+
+}  // namespace runtime
+
+namespace std {
+
+template <>
+struct hash<runtime::Symbol> {
+    size_t operator()(runtime::Symbol symbol) const noexcept {
+        return symbol.GetId();
+    }
+};
+
+}  // namespace std
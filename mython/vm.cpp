@@ -0,0 +1,327 @@
+#include "vm.h"
+
+#include "gc.h"
+
+#include <iostream>
+#include <optional>
+
+using namespace std;
+
+namespace runtime {
+
+using bytecode::OpCode;
+
+namespace {
+const Symbol INIT_METHOD = "__init__"sv;
+const Symbol SELF = "self"sv;
+}  // namespace
+
+VM::VM(const bytecode::Program& program) : program_(program) {
+}
+
+ObjectHolder VM::Pop() {
+    ObjectHolder value = std::move(stack_.back());
+    stack_.pop_back();
+    return value;
+}
+
+const bytecode::Chunk* VM::FindChunk(const Method& method) const {
+    if (auto it = program_.methods.find(method.body.get()); it != program_.methods.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+void VM::PushFrame(const bytecode::Chunk& chunk, const Method& method, ObjectHolder self,
+                   size_t args_begin, size_t stack_base, bool keep_instance) {
+    Frame& frame = frames_.emplace_back();
+    frame.chunk = &chunk;
+    frame.closure = &frame.locals;
+    frame.keep_instance = keep_instance;
+    if (GcHeap* heap = GcHeap::GetCurrent()) {
+        frame.root.emplace(*heap, frame.locals);
+    }
+
+    if (method.frame_size != 0) {
+        frame.locals.AllocateFrame(method.frame_size);
+        frame.locals.Slot(0) = std::move(self);
+        for (size_t i = 0; i < method.formal_params.size(); ++i) {
+            frame.locals.Slot(i + 1) = std::move(stack_[args_begin + i]);
+        }
+    } else {
+        frame.locals[SELF] = std::move(self);
+        for (size_t i = 0; i < method.formal_params.size(); ++i) {
+            frame.locals[method.formal_params[i]] = std::move(stack_[args_begin + i]);
+        }
+    }
+    stack_.resize(stack_base);
+    frame.stack_base = stack_base;
+    // Вход в метод: аргументы перенесены в кадр, остальные значения - на стеке
+    GcHeap::SafePoint();
+}
+
+ObjectHolder VM::Run(Closure& closure, Context& context) {
+    stack_.clear();
+    frames_.clear();
+
+    Frame& main_frame = frames_.emplace_back();
+    main_frame.chunk = &program_.main;
+    main_frame.closure = &closure;
+
+    std::optional<GcHeap::Root> root;
+    if (GcHeap* heap = GcHeap::GetCurrent()) {
+        root.emplace(*heap, closure);
+    }
+    GcHeap::Pin stack_pin(stack_);
+
+    try {
+        Frame* frame = &frames_.back();
+        for (;;) {
+            const bytecode::Instruction& instr = frame->chunk->code[frame->ip++];
+
+            switch (instr.op) {
+                case OpCode::PushConst:
+                    stack_.push_back(frame->chunk->constants[instr.a]);
+                    break;
+
+                case OpCode::PushNone:
+                    stack_.emplace_back();
+                    break;
+
+                case OpCode::Pop:
+                    stack_.pop_back();
+                    // Результат инструкции снят, все остальные значения - на стеке или в кадрах
+                    GcHeap::SafePoint();
+                    break;
+
+                case OpCode::LoadVar: {
+                    const Symbol name = frame->chunk->names[instr.a];
+                    auto it = frame->closure->find(name);
+                    if (it == frame->closure->end()) {
+                        throw runtime_error("Var name dont exists");
+                    }
+                    stack_.push_back(it->second);
+                    break;
+                }
+
+                case OpCode::StoreVar:
+                    (*frame->closure)[frame->chunk->names[instr.a]] = stack_.back();
+                    break;
+
+                case OpCode::LoadSlot:
+                    if (!frame->closure->IsBound(instr.a)) {
+                        throw runtime_error("Var name dont exists");
+                    }
+                    stack_.push_back(frame->closure->Slot(instr.a));
+                    break;
+
+                case OpCode::StoreSlot:
+                    frame->closure->Slot(instr.a) = stack_.back();
+                    break;
+
+                case OpCode::LoadField: {
+                    ClassInstance* instance = stack_.back().TryAs<ClassInstance>();
+                    if (instance == nullptr) {
+                        throw runtime_error("Item_not_found_in_closure_555");
+                    }
+                    stack_.back() = ObjectHolder(frame->chunk->field_caches[instr.c].Get(instance->Fields(), frame->chunk->names[instr.a]));
+                    break;
+                }
+
+                case OpCode::StoreField: {
+                    ObjectHolder value = Pop();
+                    ClassInstance* instance = stack_.back().TryAs<ClassInstance>();
+                    if (instance == nullptr) {
+                        throw runtime_error("bad field assignment");
+                    }
+                    frame->chunk->field_caches[instr.c].Get(instance->Fields(), frame->chunk->names[instr.a]) = value;
+                    stack_.back() = std::move(value);
+                    break;
+                }
+
+                case OpCode::Print: {
+                    ostream& os = context.GetOutputStream();
+                    const size_t first = stack_.size() - instr.a;
+                    for (size_t i = first; i < stack_.size(); ++i) {
+                        if (i != first) {
+                            os << ' ';
+                        }
+                        if (stack_[i]) {
+                            stack_[i]->Print(os, context);
+                        } else {
+                            os << "None";
+                        }
+                    }
+                    os << endl;
+
+                    ObjectHolder last_printed_value = instr.a != 0 ? stack_.back() : ObjectHolder();
+                    stack_.resize(first);
+                    stack_.push_back(std::move(last_printed_value));
+                    break;
+                }
+
+                case OpCode::CallMethod: {
+                    const Symbol name = frame->chunk->names[instr.a];
+                    const size_t receiver = stack_.size() - instr.b - 1;
+                    ClassInstance* instance = stack_[receiver].TryAs<ClassInstance>();
+                    const Method* method_ptr = instance != nullptr
+                        ? frame->chunk->method_caches[instr.c].Lookup(instance->GetClass(), name, instr.b)
+                        : nullptr;
+                    if (method_ptr == nullptr) {
+                        throw runtime_error("Bad method call");
+                    }
+
+                    const Method& method = *method_ptr;
+                    if (const bytecode::Chunk* chunk = FindChunk(method); chunk != nullptr) {
+                        ObjectHolder self = std::move(stack_[receiver]);
+                        PushFrame(*chunk, method, std::move(self), receiver + 1, receiver, false);
+                        frame = &frames_.back();
+                    } else {
+                        vector<ObjectHolder> args(stack_.begin() + receiver + 1, stack_.end());
+                        ObjectHolder result = instance->Call(method, args, context);
+                        stack_.resize(receiver);
+                        stack_.push_back(std::move(result));
+                    }
+                    break;
+                }
+
+                case OpCode::NewInstance:
+                    stack_.push_back(ObjectHolder::Own(ClassInstance(*frame->chunk->classes[instr.a])));
+                    break;
+
+                case OpCode::Construct: {
+                    const Class& cls = *frame->chunk->classes[instr.a];
+                    ObjectHolder instance = ObjectHolder::Own(ClassInstance(cls));
+                    const Method& method = *cls.GetMethod(INIT_METHOD);
+                    const size_t args_begin = stack_.size() - instr.b;
+
+                    if (const bytecode::Chunk* chunk = FindChunk(method); chunk != nullptr) {
+                        // Созданный объект остаётся на стеке под кадром __init__
+                        stack_.insert(stack_.begin() + args_begin, instance);
+                        PushFrame(*chunk, method, std::move(instance), args_begin + 1, args_begin + 1,
+                                  true);
+                        frame = &frames_.back();
+                    } else {
+                        vector<ObjectHolder> args(stack_.begin() + args_begin, stack_.end());
+                        instance.TryAs<ClassInstance>()->Call(INIT_METHOD, args, context);
+                        stack_.resize(args_begin);
+                        stack_.push_back(std::move(instance));
+                    }
+                    break;
+                }
+
+                case OpCode::Stringify:
+                    stack_.back() = runtime::Stringify(stack_.back(), context);
+                    break;
+
+                case OpCode::Add: {
+                    ObjectHolder rhs = Pop();
+                    stack_.back() = runtime::Add(stack_.back(), rhs, context);
+                    break;
+                }
+
+                case OpCode::Sub: {
+                    ObjectHolder rhs = Pop();
+                    stack_.back() = runtime::Sub(stack_.back(), rhs);
+                    break;
+                }
+
+                case OpCode::Mult: {
+                    ObjectHolder rhs = Pop();
+                    stack_.back() = runtime::Mult(stack_.back(), rhs);
+                    break;
+                }
+
+                case OpCode::Div: {
+                    ObjectHolder rhs = Pop();
+                    stack_.back() = runtime::Div(stack_.back(), rhs);
+                    break;
+                }
+
+                case OpCode::Compare: {
+                    ObjectHolder rhs = Pop();
+                    const bool result = (*frame->chunk->comparators[instr.a])(stack_.back(), rhs, context);
+                    stack_.back() = ObjectHolder::Own(Bool(result));
+                    break;
+                }
+
+                case OpCode::Not:
+                    if (!stack_.back()) {
+                        throw runtime_error("Bad_not");
+                    }
+                    stack_.back() = ObjectHolder::Own(Bool(!IsTrue(stack_.back())));
+                    break;
+
+                case OpCode::ToBool:
+                    if (!stack_.back()) {
+                        throw runtime_error(static_cast<bytecode::LogicalOp>(instr.a) == bytecode::LogicalOp::Or
+                                                ? "Bad_or"
+                                                : "Bad_and");
+                    }
+                    stack_.back() = ObjectHolder::Own(Bool(IsTrue(stack_.back())));
+                    break;
+
+                case OpCode::JumpIfTrueOrPop:
+                    if (IsTrue(stack_.back())) {
+                        frame->ip = instr.a;
+                    } else {
+                        stack_.pop_back();
+                    }
+                    break;
+
+                case OpCode::JumpIfFalseOrPop:
+                    if (!IsTrue(stack_.back())) {
+                        frame->ip = instr.a;
+                    } else {
+                        stack_.pop_back();
+                    }
+                    break;
+
+                case OpCode::JumpIfFalse:
+                    if (!IsTrue(Pop())) {
+                        frame->ip = instr.a;
+                    }
+                    break;
+
+                case OpCode::Jump:
+                    frame->ip = instr.a;
+                    break;
+
+                case OpCode::Return: {
+                    ObjectHolder result = Pop();
+                    if (frames_.size() == 1) {
+                        frames_.clear();
+                        stack_.clear();
+                        return result;
+                    }
+
+                    stack_.resize(frame->stack_base);
+                    const bool keep_instance = frame->keep_instance;
+                    frames_.pop_back();
+                    frame = &frames_.back();
+                    if (!keep_instance) {
+                        stack_.push_back(std::move(result));
+                    }
+                    break;
+                }
+
+                case OpCode::DefineClass: {
+                    const ObjectHolder& cls = frame->chunk->constants[instr.a];
+                    (*frame->closure)[cls.TryAs<Class>()->GetName()] = cls;
+                    stack_.push_back(cls);
+                    break;
+                }
+
+                case OpCode::Execute:
+                    stack_.push_back(frame->chunk->nodes[instr.a]->Execute(*frame->closure, context));
+                    break;
+            }
+        }
+    } catch (...) {
+        frames_.clear();
+        stack_.clear();
+        throw;
+    }
+}
+
+}  // namespace runtime
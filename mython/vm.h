@@ -0,0 +1,56 @@
+#pragma once
+
+#include "bytecode.h"
+#include "gc.h"
+#include "runtime.h"
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace runtime {
+
+/*
+ * Стековая виртуальная машина, исполняющая байт-код, полученный из bytecode::Compile.
+ * Все вызовы методов, скомпилированных в программу, выполняются в одном цикле диспетчеризации
+ * без рекурсии. Методы, для которых байт-кода нет, вызываются через ClassInstance::Call.
+ * При исполнении с кучей GcHeap стек значений закреплён в ней, а таблицы символов кадров
+ * служат корнями, поэтому безопасной точкой сборки является граница любой инструкции
+ * и вход в метод
+ */
+class VM {
+public:
+    explicit VM(const bytecode::Program& program);
+
+    // Исполняет основной фрагмент программы, используя closure как глобальную таблицу символов.
+    // Возвращает значение, оставленное программой на стеке
+    ObjectHolder Run(Closure& closure, Context& context);
+
+private:
+    struct Frame {
+        const bytecode::Chunk* chunk = nullptr;
+        size_t ip = 0;
+        Closure* closure = nullptr;
+        // Размер стека до вызова. При возврате стек усекается до этого размера
+        size_t stack_base = 0;
+        // true для __init__: результат вызова отбрасывается, на стеке остаётся созданный объект
+        bool keep_instance = false;
+        Closure locals;
+        // Таблица символов кадра - корень текущей кучи GcHeap, пока кадр открыт
+        std::optional<GcHeap::Root> root;
+    };
+
+    ObjectHolder Pop();
+    // Открывает кадр вызова method. Аргументы переносятся со стека, начиная с позиции args_begin,
+    // после чего стек усекается до stack_base
+    void PushFrame(const bytecode::Chunk& chunk, const Method& method, ObjectHolder self,
+                   size_t args_begin, size_t stack_base, bool keep_instance);
+    const bytecode::Chunk* FindChunk(const Method& method) const;
+
+    const bytecode::Program& program_;
+    std::vector<ObjectHolder> stack_;
+    // deque сохраняет адреса кадров, на таблицы символов которых ссылаются Frame::closure
+    std::deque<Frame> frames_;
+};
+
+}  // namespace runtime
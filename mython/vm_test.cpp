@@ -0,0 +1,250 @@
+#include "bytecode.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+#include "test_runner_p.h"
+#include "vm.h"
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+string RunTreeWalker(const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    DummyContext context;
+    Closure closure;
+    tree->Execute(closure, context);
+    return context.output.str();
+}
+
+string RunVm(const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+    bytecode::Program code = bytecode::Compile(*tree);
+
+    DummyContext context;
+    Closure closure;
+    VM vm(code);
+    vm.Run(closure, context);
+    return context.output.str();
+}
+
+#define ASSERT_SAME_OUTPUT(program, expected)   \
+    {                                           \
+        ASSERT_EQUAL(RunTreeWalker(program), expected); \
+        ASSERT_EQUAL(RunVm(program), expected);         \
+    }
+
+void TestVmExpressions() {
+    const string program = R"(
+x = 4
+y = 5
+z = "hello, "
+print x + y, z + "world", x * y - 20 / 4, -x
+print x < y, x == y, x != y, x >= 4, not x, str(y) + str(None) + str(True)
+print 0 or 0, x and "yes", 0 and "never evaluated"
+print
+)"s;
+    ASSERT_SAME_OUTPUT(program, "9 hello, world 15 -4\nTrue False True True False 5NoneTrue\nFalse True False\n\n"s);
+}
+
+void TestVmClassesAndCalls() {
+    const string program = R"(
+class Counter:
+  def __init__(start):
+    self.value = start
+
+  def add(n):
+    self.value = self.value + n
+    return self
+
+  def __str__():
+    return 'Counter(' + str(self.value) + ')'
+
+class LoudCounter(Counter):
+  def add(n):
+    print 'adding', n
+    self.value = self.value + n * 10
+    return self
+
+c = Counter(1)
+c.add(2)
+d = c.add(3)
+l = LoudCounter(0)
+l.add(1)
+print d, l, c.value + l.value
+)"s;
+    ASSERT_SAME_OUTPUT(program, "adding 1\nCounter(6) Counter(10) 16\n"s);
+}
+
+void TestVmReturnAndRecursion() {
+    const string program = R"(
+class GCD:
+  def __init__():
+    self.call_count = 0
+
+  def calc(a, b):
+    self.call_count = self.call_count + 1
+    if a < b:
+      return self.calc(b, a)
+    if b == 0:
+      return a
+    return self.calc(a - b, b)
+
+x = GCD()
+print x.calc(510510, 18629977)
+print x.calc(22, 17)
+print x.call_count
+)"s;
+    ASSERT_SAME_OUTPUT(program, "17\n1\n115\n"s);
+}
+
+void TestVmInitArityMismatchSkipsArguments() {
+    const string program = R"(
+class Logger:
+  def log(msg):
+    print msg
+    return 1
+
+class Empty:
+  def __init__():
+    self.x = 0
+
+logger = Logger()
+e = Empty(logger.log('not printed'))
+print e.x
+)"s;
+    ASSERT_SAME_OUTPUT(program, "None\n"s);
+}
+
+void TestVmFieldCachesPerSite() {
+    const string program = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+p = Point(1, 2)
+q = Point(3, 4)
+print p.x, p.y, q.x, q.y
+)"s;
+    ASSERT_SAME_OUTPUT(program, "1 2 3 4\n"s);
+}
+
+void TestVmLoops() {
+    const string program = R"(
+class Math:
+  def gcd(a, b):
+    while b != 0:
+      if a < b:
+        t = a
+        a = b
+        b = t
+        continue
+      a = a - b
+    return a
+
+  def first_square_above(n):
+    i = 0
+    while True:
+      i = i + 1
+      if i * i > n:
+        return i
+
+m = Math()
+i = 0
+total = 0
+while i < 10:
+  i = i + 1
+  if i == 3:
+    continue
+  if i > 6:
+    break
+  j = 0
+  while j < i:
+    j = j + 1
+    total = total + 1
+print i, total, m.gcd(510510, 18629977), m.first_square_above(50)
+while False:
+  print 'never'
+)"s;
+    ASSERT_SAME_OUTPUT(program, "7 18 17 8\n"s);
+}
+
+void TestVmLocalReadBeforeAssignmentInLoop() {
+    const string program = R"(
+class C:
+  def f():
+    i = 0
+    while i < 4:
+      if i > 1:
+        print y
+      y = i
+      i = i + 1
+    return i
+
+c = C()
+print c.f()
+)"s;
+    ASSERT_SAME_OUTPUT(program, "1\n2\n4\n"s);
+    ASSERT_THROWS(RunVm("class C:\n  def f():\n    print x\n    x = 1\nc = C()\nc.f()\n"s), runtime_error);
+}
+
+void TestVmErrors() {
+    ASSERT_THROWS(RunVm("x = None or 1\n"s), runtime_error);
+    ASSERT_THROWS(RunVm("x = 1 / 0\n"s), runtime_error);
+    ASSERT_THROWS(RunVm("print y\n"s), runtime_error);
+    ASSERT_THROWS(RunVm("class A:\n  def f():\n    return 1\na = A()\na.g()\n"s), runtime_error);
+    ASSERT_THROWS(RunVm("class A:\n  def f(c):\n    if c:\n      y = 1\n    return y\na = A()\na.f(False)\n"s), runtime_error);
+}
+
+void TestVmFallsBackToTreeWalkingForForeignNodes() {
+    struct Constant : Executable {
+        ObjectHolder Execute(Closure& /*closure*/, Context& /*context*/) override {
+            return ObjectHolder::Own(Number{42});
+        }
+    };
+
+    vector<Method> methods;
+    methods.push_back({"answer"s, {}, make_unique<Constant>()});
+    Class cls{"Oracle"s, std::move(methods), nullptr};
+
+    ast::Compound program;
+    program.AddStatement(make_unique<ast::Assignment>("x"s, make_unique<ast::NewInstance>(cls)));
+    program.AddStatement(make_unique<ast::Print>(make_unique<ast::MethodCall>(
+        make_unique<ast::VariableValue>("x"s), "answer"s, vector<unique_ptr<ast::Statement>>{})));
+    program.AddStatement(make_unique<Constant>());
+
+    bytecode::Program code = bytecode::Compile(program);
+    DummyContext context;
+    Closure closure;
+    VM vm(code);
+    vm.Run(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "42\n"s);
+    ASSERT(code.methods.empty());
+}
+
+#undef ASSERT_SAME_OUTPUT
+
+}  // namespace
+
+void RunVmTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestVmExpressions);
+    RUN_TEST(tr, runtime::TestVmClassesAndCalls);
+    RUN_TEST(tr, runtime::TestVmReturnAndRecursion);
+    RUN_TEST(tr, runtime::TestVmInitArityMismatchSkipsArguments);
+    RUN_TEST(tr, runtime::TestVmFieldCachesPerSite);
+    RUN_TEST(tr, runtime::TestVmLoops);
+    RUN_TEST(tr, runtime::TestVmLocalReadBeforeAssignmentInLoop);
+    RUN_TEST(tr, runtime::TestVmErrors);
+    RUN_TEST(tr, runtime::TestVmFallsBackToTreeWalkingForForeignNodes);
+}
+
+}  // namespace runtime